@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include "loaders.hpp"
+#include "synthetic.hpp"
 
 // Global flag for progress bar visibility (defined in main.cpp)
 extern bool g_show_progress;
@@ -13,21 +14,91 @@ struct DatasetConfig {
     std::vector<std::string> feature_cols;
     std::string target_col;
     bool needs_encoding;
+    bool is_synthetic = false;         // Generate synthetic in memory instead of reading path
+    synthetic_config synthetic;
 };
 
 struct BenchmarkResult {
     std::string config_name;
-    double training_time_ms;
+    double load_time_ms = 0.0;         // CSV import, subsampling, split and encoding
+    double training_time_ms = 0.0;     // fit() only
+    double predict_time_ms = 0.0;      // predict() on the test set only
+    size_t train_samples = 0;
+    size_t test_samples = 0;
+    int num_trees = 1;
+    double train_throughput = 0.0;     // Training samples x trees per second
+    double predict_throughput = 0.0;   // Test rows per second
     double accuracy;
     double precision;
     double recall;
     double f1_score;
-    double speedup;
+    double speedup = 1.0;              // Training speedup vs the baseline configuration
+    double predict_speedup = 1.0;      // Inference speedup vs the baseline configuration
 };
 
 // Forward declarations
 class decision_tree;
 class random_forest;
+struct tree_hyperparameters;
+struct tree_growing_config;
+struct random_forest_config;
+
+// Repeated-run harness settings: data is loaded once, every configuration is
+// run warmup_runs times untimed, then repetitions times timed
+struct HarnessConfig {
+    int warmup_runs = 1;
+    int repetitions = 5;
+    int num_threads = 0;               // OpenMP threads per run (0 = omp_get_max_threads())
+    bool pin_threads = true;           // Pin OpenMP thread i to the i-th allowed CPU for each run (Linux;
+                                       // outer team only, nested teams unpinned; restored afterwards)
+    std::string json_path;             // Machine-readable output, skipped if empty
+    std::string csv_path;
+    
+    // Model settings (nullptr = the benchmark defaults); use_parallel and num_trees
+    // are still set by each configuration
+    const tree_hyperparameters* hp_config = nullptr;
+    const tree_growing_config* growing_config = nullptr;
+    const random_forest_config* rf_config = nullptr;
+};
+
+// Summary of one phase's timings over the timed repetitions
+struct TimingStats {
+    int samples = 0;
+    double median = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    double mean = 0.0;
+    double stddev = 0.0;               // Sample standard deviation
+    double ci95_low = 0.0;             // 95% confidence interval of the mean (Student's t)
+    double ci95_high = 0.0;
+};
+
+struct HarnessResult {
+    std::string config_name;
+    int num_threads = 1;
+    int num_trees = 1;
+    bool pinned = false;
+    size_t train_samples = 0;
+    size_t test_samples = 0;
+    std::vector<double> train_times_ms;     // One entry per timed repetition
+    std::vector<double> predict_times_ms;
+    TimingStats train_stats;
+    TimingStats predict_stats;
+    double mean_accuracy = 0.0;
+};
+
+// One point of a thread-scaling sweep (speedups are against the same configuration at 1 thread)
+struct ScalingResult {
+    std::string config_name;
+    std::string mode;                  // "strong" (fixed data) or "weak" (training rows grow with threads)
+    int num_threads = 1;
+    size_t train_samples = 0;
+    double median_train_ms = 0.0;
+    double stddev_train_ms = 0.0;
+    double speedup = 1.0;              // strong: T1 / Tp; weak: scaled speedup p * T1 / Tp
+    double efficiency = 1.0;           // speedup / p
+    double serial_fraction = 0.0;      // strong: Karp-Flatt; weak: Gustafson (p - S) / (p - 1)
+};
 
 // Benchmark runner functions
 BenchmarkResult run_decision_tree_benchmark(
@@ -48,10 +119,29 @@ BenchmarkResult run_random_forest_benchmark(
 void benchmark_decision_tree(const DatasetConfig& dataset_config);
 void benchmark_random_forest(const DatasetConfig& dataset_config, int num_trees);
 void benchmark_sample_sizes(const DatasetConfig& dataset_config, int num_trees);
+void benchmark_cross_validation(const DatasetConfig& dataset_config, int num_trees, int num_folds);
+void benchmark_grid_search(const DatasetConfig& dataset_config, int max_trees);
+
+// Repeated benchmark of every parallelism configuration (num_trees = 0: decision tree)
+std::vector<HarnessResult> benchmark_repeated(const DatasetConfig& dataset_config, int num_trees, const HarnessConfig& harness);
+
+// Strong and weak scaling sweep over 1..harness.num_threads threads (0 = omp_get_num_procs())
+// for forest-level, tree-level and combined parallelism
+std::vector<ScalingResult> benchmark_scaling(const DatasetConfig& dataset_config, int num_trees, const HarnessConfig& harness);
 
 // Utility functions
 void print_benchmark_table(const std::vector<BenchmarkResult>& results);
+void set_speedups(BenchmarkResult& result, const BenchmarkResult& baseline);
+TimingStats summarize_timings(const std::vector<double>& samples_ms);
+void print_harness_table(const std::vector<HarnessResult>& results);
+void write_harness_json(const std::string& path, const DatasetConfig& dataset_config, const HarnessConfig& harness, const std::vector<HarnessResult>& results);
+void write_harness_csv(const std::string& path, const DatasetConfig& dataset_config, const std::vector<HarnessResult>& results);
+void print_scaling_table(const std::vector<ScalingResult>& results);
+void write_scaling_csv(const std::string& path, const DatasetConfig& dataset_config, const std::vector<ScalingResult>& results);
 DatasetConfig get_dataset_config(int datasetChoice);
+DatasetConfig get_synthetic_dataset_config(const synthetic_config& synthetic);
+// Load the configured data set, dropping rows whose target is missing
+data_frame load_dataset(const DatasetConfig& dataset_config);
 
 #endif // BENCHMARK_HPP
 
@@ -0,0 +1,42 @@
+#ifndef BINARY_IO_HPP
+#define BINARY_IO_HPP
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+// Little helpers for the binary model / data files (native byte order)
+
+template <typename T>
+inline void write_pod(ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+inline T read_pod(istream& in) {
+    T value;
+    if (!in.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+        throw runtime_error("Unexpected end of binary file");
+    }
+    return value;
+}
+
+inline void write_string(ostream& out, const string& value) {
+    write_pod(out, (uint32_t)value.size());
+    out.write(value.data(), value.size());
+}
+
+inline string read_string(istream& in) {
+    uint32_t len = read_pod<uint32_t>(in);
+    string value(len, '\0');
+    if (len > 0 && !in.read(&value[0], len)) {
+        throw runtime_error("Unexpected end of binary file");
+    }
+    return value;
+}
+
+#endif // BINARY_IO_HPP
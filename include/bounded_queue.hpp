@@ -0,0 +1,78 @@
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+using namespace std;
+
+// Blocking FIFO with a fixed capacity, connecting the stages of a pipeline.
+// push() blocks while full (back-pressure), pop() blocks while empty.
+// close() wakes everyone: pushes are dropped and pop() drains what is left.
+// try_pop_until() bounds the wait (used to cap micro-batch latency).
+template <typename T>
+class bounded_queue {
+private:
+    deque<T> items;
+    size_t capacity;
+    bool closed = false;
+    mutable mutex lock;
+    condition_variable not_full;
+    condition_variable not_empty;
+
+public:
+    explicit bounded_queue(size_t capacity) : capacity(capacity > 0 ? capacity : 1) {}
+
+    // Returns false if the queue was closed
+    bool push(T item) {
+        unique_lock<mutex> guard(lock);
+        not_full.wait(guard, [&] { return closed || items.size() < capacity; });
+        if (closed) return false;
+
+        items.push_back(move(item));
+        not_empty.notify_one();
+        return true;
+    }
+
+    // Returns false once the queue is closed and drained
+    bool pop(T& item) {
+        unique_lock<mutex> guard(lock);
+        not_empty.wait(guard, [&] { return closed || !items.empty(); });
+        if (items.empty()) return false;
+
+        item = move(items.front());
+        items.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+
+    // Like pop(), but gives up at deadline; returns false on timeout or once closed and drained
+    template <typename Clock, typename Duration>
+    bool try_pop_until(T& item, const chrono::time_point<Clock, Duration>& deadline) {
+        unique_lock<mutex> guard(lock);
+        not_empty.wait_until(guard, deadline, [&] { return closed || !items.empty(); });
+        if (items.empty()) return false;
+
+        item = move(items.front());
+        items.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+
+    void close() {
+        lock_guard<mutex> guard(lock);
+        closed = true;
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+
+    size_t size() const {
+        lock_guard<mutex> guard(lock);
+        return items.size();
+    }
+};
+
+#endif // BOUNDED_QUEUE_HPP
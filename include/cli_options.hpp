@@ -0,0 +1,52 @@
+#ifndef CLI_OPTIONS_HPP
+#define CLI_OPTIONS_HPP
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// key=value settings for the non-interactive commands, from command-line flags
+// (--key=value, --key value, or --flag for true) and config files (one key = value
+// per line, # starts a comment). Dashes in keys are read as underscores, so
+// --max-depth and max_depth name the same setting. Sources are applied in order:
+// --config FILE is read where it appears, and later settings override earlier ones.
+//
+// Every getter marks its key as used; check_all_used() then rejects typos before
+// a long run starts.
+class cli_options {
+private:
+    map<string, string> values;
+    mutable set<string> used;
+
+    void set_value(const string& key, const string& value);
+
+public:
+    // Parse argv[first..argc); throws invalid_argument on malformed input
+    static cli_options parse(int argc, char** argv, int first);
+
+    // Merge a key = value config file (throws if unreadable or malformed)
+    void load_file(const string& path);
+
+    bool has(const string& key) const;
+
+    // Typed getters: the default is returned if key is not set; a value that does not
+    // parse as the requested type throws invalid_argument naming the key
+    string get_string(const string& key, const string& default_value) const;
+    int get_int(const string& key, int default_value) const;
+    size_t get_size(const string& key, size_t default_value) const;
+    double get_double(const string& key, double default_value) const;
+    bool get_bool(const string& key, bool default_value) const;     // true/false, yes/no, on/off, 1/0
+
+    // Comma-separated list (empty if key is not set)
+    vector<string> get_list(const string& key) const;
+    vector<int> get_int_list(const string& key, const vector<int>& default_value) const;
+    vector<double> get_double_list(const string& key, const vector<double>& default_value) const;
+
+    // Throws invalid_argument listing every set key no getter has asked for
+    void check_all_used() const;
+};
+
+#endif // CLI_OPTIONS_HPP
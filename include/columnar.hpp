@@ -0,0 +1,67 @@
+#ifndef COLUMNAR_HPP
+#define COLUMNAR_HPP
+
+#include "loaders.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Read-only, memory-mapped columnar copy of a CSV file for out-of-core training.
+// Columns are stored contiguously (int32 / float64 / int32 dictionary codes), so a
+// sorted set of rows can be streamed out of the mapping without loading the file.
+// Missing values are stored in place: NaN in float columns, INT32_MIN in int columns.
+//
+// File layout:
+//   magic "PRFCOL1\0" | num_rows (u64) | num_cols (u32)
+//   per column: name length (u32), name, type (u8), data offset (u64),
+//               dictionary offset (u64), dictionary size (u64)
+//   column data sections (8-byte aligned), then string dictionaries
+class columnar_file {
+private:
+    struct column_info {
+        string name;
+        string type;                       // "int", "float" or "string"
+        uint64_t data_offset = 0;
+        vector<string> dictionary;         // Code -> value (string columns)
+        vector<string> sorted_categories;  // Encoding order used by string_col::fit_encoding
+    };
+
+    int fd = -1;
+    const char* base = nullptr;            // Start of the mapping
+    size_t file_size = 0;
+    size_t num_rows = 0;
+    vector<column_info> columns;
+
+    const column_info& find_column(const string& name) const;
+
+public:
+    // Mapping is owned; prevent copy
+    explicit columnar_file(const string& path);
+    ~columnar_file();
+    columnar_file(const columnar_file&) = delete;
+    columnar_file& operator=(const columnar_file&) = delete;
+
+    // Stream a CSV file into columnar format, chunk_rows rows at a time (two passes:
+    // infer types and count rows, then write). Memory use is bounded by chunk_rows.
+    static void convert_csv(const string& csv_path, const string& out_path, size_t chunk_rows = 65536);
+
+    size_t get_num_rows() const;
+    vector<string> get_column_names() const;
+    string get_column_type(const string& name) const;
+
+    // Distinct values of a string column, in encoding order
+    const vector<string>& get_categories(const string& name) const;
+
+    // Number of target classes (dictionary size for string targets, max + 1 for int targets)
+    int count_classes(const string& target_col) const;
+
+    // Copy the given rows (duplicates allowed; sorted rows stream sequentially) of the
+    // given columns into an in-memory data_frame. String columns get the encoding of
+    // the whole file, so codes agree across every materialized subset.
+    data_frame materialize(const vector<size_t>& row_indices, const vector<string>& column_names) const;
+};
+
+#endif // COLUMNAR_HPP
@@ -0,0 +1,69 @@
+#ifndef COMPACT_FOREST_HPP
+#define COMPACT_FOREST_HPP
+
+#include "flat_forest.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Compact serving variant of a flat_forest (about a quarter of its size).
+// Thresholds become 16-bit indices into each feature's sorted list of
+// training split points: a row value is mapped once to its bin
+// (first split point >= value), and x <= t[k] becomes bin <= k, so class
+// predictions are exactly those of the full model. Leaf probabilities are
+// stored as uint16 fractions of 65535 (error <= 7.7e-6 per leaf), pooled
+// like the flat_forest's: one-hot leaves store only their class.
+class compact_forest {
+private:
+    static constexpr uint16_t LEAF = 0xFFFF;            // feature value of a leaf node
+    static constexpr uint16_t CATEGORICAL = 0x8000;     // feature flag: split is bin == value
+    static constexpr uint16_t MISSING_LEFT = 0x4000;    // feature flag: numeric split sends NaN left
+    static constexpr uint16_t FEATURE_MASK = 0x3FFF;
+    static constexpr uint16_t MISSING_BIN = 0xFFFF;     // NaN / unseen category: never <= or == a split
+    static constexpr uint32_t ONE_HOT = 0xFFFFFFFF;     // Leaf without a pooled distribution
+
+    struct compact_node {
+        uint16_t feature;          // Feature index (| CATEGORICAL / MISSING_LEFT), or LEAF
+        uint16_t value;            // Split bin or category code; leaves: predicted class
+        uint32_t right_or_leaf;    // Right child (left child is the next node); leaves: pool offset or ONE_HOT
+    };
+
+    vector<compact_node> nodes;
+    vector<uint32_t> roots;
+    vector<uint16_t> leaf_probabilities;            // Quantized copy of the flat_forest's leaf pool
+    vector<vector<double>> split_points;            // Per numeric feature: sorted unique thresholds
+    vector<bool> is_categorical;
+    int num_classes = 0;
+
+    // Helper: Copy a flat subtree in preorder, returns its node index
+    uint32_t append_node(const flat_forest& full, int node_idx);
+
+public:
+    // Build from a flattened forest (throws if it exceeds the 16-bit limits)
+    void build(const flat_forest& full);
+
+    bool empty() const;
+    int get_num_classes() const;
+
+    // Bytes used by nodes, leaves and split tables
+    size_t memory_bytes() const;
+
+    // Same contract as flat_forest::predict_row
+    int predict_row(const double* row, double* proba_out) const;
+};
+
+// Agreement between the full-precision and compact models on a data set
+struct compact_check {
+    size_t rows = 0;
+    size_t class_mismatches = 0;
+    double max_probability_error = 0.0;
+    double full_accuracy = -1.0;       // -1 if the data has no target column
+    double compact_accuracy = -1.0;
+    size_t full_bytes = 0;
+    size_t compact_bytes = 0;
+};
+
+#endif // COMPACT_FOREST_HPP
@@ -0,0 +1,72 @@
+#ifndef CROSS_VALIDATION_HPP
+#define CROSS_VALIDATION_HPP
+
+#include "decision_tree.hpp"
+#include "random_forest.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Configuration for k-fold cross-validation
+struct cv_config {
+    int num_folds = 5;             // k (>= 2)
+    unsigned int seed = 42;        // Seed for shuffling rows into folds
+    bool use_parallel = true;      // Train folds concurrently (each fold's forest then trains serially)
+};
+
+// One fold as index views over the shared data_frame
+struct kfold_split {
+    vector<size_t> train_indices;
+    vector<size_t> test_indices;
+};
+
+// Timing and metrics of a single fold
+struct fold_result {
+    int fold;
+    size_t train_rows;
+    size_t test_rows;
+    double train_time_ms;
+    double predict_time_ms;
+    double accuracy;
+    double precision;
+    double recall;
+    double f1_score;
+};
+
+// Per-fold results plus their aggregate
+struct cv_result {
+    vector<fold_result> folds;
+    double mean_accuracy;
+    double stddev_accuracy;
+    double mean_f1_score;
+    double wall_time_ms;           // End-to-end time of all folds
+};
+
+// Helper: Shuffle the given rows and deal them into k folds
+vector<kfold_split> make_kfold_splits(const vector<size_t>& rows, int num_folds, unsigned int seed);
+
+// Helper: Encoded target label of every row (fits the string encoding if needed;
+// -1 where an int target is missing, such rows belong in no fold)
+vector<int> encoded_targets(const data_frame& df, const string& target_col);
+
+// k-fold cross-validation of a random forest over one loaded data_frame.
+// All folds read the same data_frame, encoded labels and target encoding;
+// nothing is reloaded or copied per fold.
+class cross_validator {
+public:
+    // Configuration pointers (user sets these manually)
+    cv_config* config = nullptr;
+    tree_hyperparameters* hp_config = nullptr;
+    tree_growing_config* growing_config = nullptr;
+    random_forest_config* rf_config = nullptr;
+
+    cv_result run(
+        const data_frame& df,
+        const vector<string>& feature_cols,
+        const string& target_col
+    ) const;
+};
+
+#endif // CROSS_VALIDATION_HPP
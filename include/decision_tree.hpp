@@ -6,6 +6,7 @@
 #include "progress.hpp"
 
 #include <omp.h>
+#include <string>
 #include <vector>
 #include <memory>
 
@@ -24,16 +25,27 @@ struct tree_growing_config {
         SHANNON_ENTROPY
     };
     
-    SplitCriterion criterion = SplitCriterion::GINI;
+    SplitCriterion criterion = SplitCriterion::GINI;  // Classification only (float targets always use variance reduction)
     int max_features_per_split = -1;  // -1 = use all features (for future random forest)
     
+    // Weighting: a row counts as sample weight x class weight in split gains,
+    // leaf distributions / means and impurity importances (min_examples_per_leaf
+    // still counts rows). Rows are never duplicated.
+    string weight_column;             // Numeric column of non-negative per-row weights ("" = all 1)
+    vector<double> class_weights;     // Per encoded class multiplier (empty = all 1; classification only)
+    bool balance_classes = false;     // Class weights total / (k * class total) from each tree's own rows
+    
     // Parallelism configuration
     bool use_parallel = false;           // Enable tree-level parallelism
     int min_samples_for_parallel = 100;  // Minimum samples in node to spawn parallel tasks
     int max_parallel_depth = 8;          // Maximum depth to spawn tasks (prevents task explosion)
 };
 
+class flat_forest;
+
 class decision_tree {
+    friend class flat_forest;  // Flattens fitted trees for inference
+    
 private:
     // Internal tree node structure
     struct TreeNode {
@@ -45,6 +57,7 @@ private:
         
         // For numerical features: feature_value <= threshold
         double threshold;
+        bool missing_left = false; // Numerical: direction of rows missing the feature
         
         // For categorical features: feature_value == split_value (one-vs-rest)
         // Extensible: can change to set<string> for subset-based splits later
@@ -54,8 +67,8 @@ private:
         unique_ptr<TreeNode> right;  // Right child
         
         // Leaf node - prediction information
-        int predicted_class;              // Class with highest probability
-        vector<double> class_probabilities;  // Probability distribution over classes
+        int predicted_class;              // Class with highest probability (0 for regression)
+        vector<double> class_probabilities;  // Probability distribution over classes (regression: {mean target})
     };
     
     unique_ptr<TreeNode> root;
@@ -63,7 +76,16 @@ private:
     // Learned during fit
     vector<string> feature_names;  // Names of features used for training
     string target_column_name;     // Name of target column
-    int num_classes;               // Number of unique classes in target
+    int num_classes;               // Number of unique classes in target (1 for regression)
+    bool regression = false;       // float_col target: variance-reduction splits, mean leaves
+    vector<double> feature_importances;  // Impurity decrease per feature (sums to 1 after fit)
+    
+    // Set for the duration of fit
+    const col* weight_col = nullptr;     // Sample weights (nullptr = unweighted)
+    vector<double> fit_class_weights;    // Resolved class multipliers (empty = all 1)
+    
+    // Helper: Weight of each row of indices (sample weight x class weight)
+    vector<double> row_weights(const vector<size_t>& indices, const vector<int>& encoded_labels) const;
     
     // Helper: Recursively build decision tree
     unique_ptr<TreeNode> build_tree(
@@ -72,13 +94,27 @@ private:
         int current_depth
     );
     
-    // Helper: Find best split for numerical feature
-    // Returns: (best_gain, best_threshold)
-    pair<double, double> find_best_numerical_split(
+    // Helper: Turn node into a leaf (class distribution, or the mean target for regression)
+    void fill_leaf(TreeNode* node, const vector<int>& encoded_labels, const vector<double>& targets,
+                   const vector<double>& weights) const;
+    
+    // Best split of a numerical feature. Rows missing the feature are left out
+    // of the sort and tried on each side of every threshold; missing_left is
+    // the better side (the larger child when the node has no missing rows).
+    struct numeric_split {
+        double gain;
+        double threshold;
+        bool missing_left;
+    };
+    
+    // Helper: Find best split for numerical feature (one sorted sweep with
+    // running per-class weight sums)
+    numeric_split find_best_numerical_split(
         const data_frame& df,
         const vector<size_t>& indices,
         int feature_idx,
-        const vector<int>& encoded_labels
+        const vector<int>& encoded_labels,
+        const vector<double>& weights
     );
     
     // Helper: Find best split for categorical feature (one-vs-rest)
@@ -87,7 +123,26 @@ private:
         const data_frame& df,
         const vector<size_t>& indices,
         int feature_idx,
-        const vector<int>& encoded_labels
+        const vector<int>& encoded_labels,
+        const vector<double>& weights
+    );
+    
+    // Helpers: Regression counterparts (gain = reduction in weighted mean squared error).
+    // One sorted sweep with running weighted sums / sums of squares per feature.
+    numeric_split find_best_numerical_regression_split(
+        const data_frame& df,
+        const vector<size_t>& indices,
+        int feature_idx,
+        const vector<double>& targets,
+        const vector<double>& weights
+    );
+    
+    pair<double, string> find_best_categorical_regression_split(
+        const data_frame& df,
+        const vector<size_t>& indices,
+        int feature_idx,
+        const vector<double>& targets,
+        const vector<double>& weights
     );
     
     // Helper: Traverse tree to predict single sample
@@ -110,7 +165,11 @@ public:
     tree_growing_config* growing_config = nullptr;
     TreeProgress* progress_tracker = nullptr;  // Optional progress tracking
     
-    // Training
+    // Lower bound on num_classes, for trees fitted on a subset that may miss
+    // some classes (keeps class_probabilities the same length across a forest)
+    int min_num_classes = 0;
+    
+    // Training (rows with a missing target are skipped; weighting per growing_config)
     void fit(
         const data_frame& df,
         const vector<string>& feature_cols,  // Names of feature columns to use
@@ -118,11 +177,25 @@ public:
         const vector<size_t>* bootstrap_indices = nullptr  // nullptr = use all rows
     );
     
+    // True when fitted on a float_col target
+    bool is_regressor() const;
+    
     // Prediction - returns encoded class labels (0, 1, 2, ...)
     vector<int> predict(const data_frame& X) const;
     
+    // Prediction for a subset of rows of X (results follow row_indices order)
+    vector<int> predict(const data_frame& X, const vector<size_t>& row_indices) const;
+    
     // Prediction - returns class probability distributions
     vector<vector<double>> predict_proba(const data_frame& X) const;
+    
+    // Regression prediction (mean target of each row's leaf)
+    vector<double> predict_values(const data_frame& X) const;
+    
+    // Mean decrease in impurity per feature (feature_cols order), accumulated
+    // while growing: each split adds rows x gain. Normalized to sum to 1
+    // (all zero for a single-leaf tree).
+    const vector<double>& get_feature_importances() const;
 };
 
 #endif // DECISION_TREE_H
\ No newline at end of file
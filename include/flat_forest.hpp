@@ -0,0 +1,124 @@
+#ifndef FLAT_FOREST_HPP
+#define FLAT_FOREST_HPP
+
+#include "decision_tree.hpp"
+
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Pointer-free, contiguous copy of a fitted forest for low-latency inference.
+// Rows are dense arrays of doubles in training feature order; categorical
+// features are given as their category code (see encode_category). A missing
+// value is NaN: numeric splits send it to their learned missing direction,
+// categorical splits to the right.
+class flat_forest {
+    friend class compact_forest;
+
+private:
+    struct flat_node {
+        int feature_idx;           // -1 for leaves
+        bool is_categorical;       // Split is feature == code instead of feature <= threshold
+        bool missing_left;         // Numeric splits: NaN goes left (stored in bit 1 of the categorical flag)
+        double threshold;          // Numeric threshold, or category code for categorical splits
+        int left;                  // Absolute node indices (left == this + 1, preorder layout)
+        int right;
+        int predicted_class;       // Leaves only
+        int leaf_offset;           // Leaves only: offset into leaf_probabilities, -1 for one-hot leaves
+    };
+
+    vector<flat_node> nodes;
+    vector<int> roots;                     // Root node index of every tree
+    vector<double> leaf_probabilities;     // Pool of distinct leaf distributions, num_classes values each
+    map<vector<double>, int> leaf_pool;    // Distribution -> offset in leaf_probabilities (interning)
+    int num_classes = 0;
+    vector<vector<string>> categories;     // Per feature: sorted category list (empty for numeric)
+
+    // Implicit complete-binary-tree ("heap") copy of shallow, numeric-only trees:
+    // children of slot i are 2i+1 / 2i+2, so traversal is idx = 2*idx+1+!(x <= t).
+    // Shorter branches are padded with pass-through splits (threshold +inf, NaN left).
+    struct heap_tree {
+        int depth;
+        int split_offset;          // 2^depth - 1 slots in heap_features / heap_thresholds
+        int leaf_offset;           // 2^depth slots in heap_leaves
+    };
+
+    static const int max_heap_depth = 10;  // Deeper trees make padding cost more than it saves
+
+    vector<heap_tree> heap_trees;
+    vector<int> heap_features;
+    vector<double> heap_thresholds;
+    vector<uint8_t> heap_missing_left;
+    vector<int> heap_leaves;               // Flat node index of each padded leaf slot
+    bool heap_enabled = true;              // False once any tree is too deep or has a categorical split
+
+    // Helper: Copy a subtree in preorder, returns its node index
+    int append_node(const decision_tree::TreeNode* node);
+
+    // Helper: Offset of a leaf distribution in the pool (-1 if one-hot on predicted_class)
+    int intern_leaf(const vector<double>& distribution, int predicted_class);
+
+    // Helper: Add a leaf's class distribution to proba
+    void add_leaf(const flat_node& leaf, double* proba) const;
+
+    // Helpers: Heap layout of the tree rooted at flat node root (disables it if ineligible)
+    int subtree_depth(int node_idx) const;   // -1 if the subtree has a categorical split
+    void fill_heap(int node_idx, int slot, int level, const heap_tree& tree);
+    void append_heap(int root);
+
+    // Helper: Emit a subtree as nested if-else C++ source
+    void write_cpp_node(ostream& out, int node_idx, int indent) const;
+
+public:
+    // Reset to an empty forest with the given schema
+    void reset(int num_classes, const vector<vector<string>>& feature_categories);
+
+    // Append a fitted tree (its feature indices must follow the schema's feature order)
+    void append_tree(const decision_tree& tree);
+
+    bool empty() const;
+    int get_num_trees() const;
+    int get_num_classes() const;
+    int get_num_features() const;  // Width of the rows predict_row / predict_rows read
+
+    // Bytes used by nodes, roots and leaf distributions (not the heap layout copy)
+    size_t memory_bytes() const;
+
+    // Distinct non-one-hot leaf distributions stored in the pool
+    int get_num_pooled_leaves() const;
+
+    // Category code of a categorical feature value (-1 if unseen in training)
+    double encode_category(int feature_idx, const string& value) const;
+
+    // Binary (de)serialization of schema, nodes and leaves
+    void write(ostream& out) const;
+    void read(istream& in);
+
+    // Score n_rows dense rows stored back to back (row-major). Same results as
+    // predict_row per row; when every tree is shallow (depth <= 10) and numeric-only,
+    // rows are traversed in blocks through the branch-free heap layout instead.
+    void predict_rows(const double* rows, size_t n_rows, size_t n_features,
+                      int* classes_out, double* proba_out) const;
+
+    // True when predict_rows can use the branch-free heap layout
+    bool uses_heap_layout() const;
+
+    // Generate a self-contained C++ header that scores rows with the trees
+    // compiled in as nested if-else (thresholds inlined as constants).
+    // Exposes extern "C" <name>_predict / <name>_encode_category / ...; see the
+    // generated file's header comment for building it as a shared object.
+    void export_cpp(ostream& out, const string& name,
+                    const vector<string>& feature_names,
+                    const vector<string>& class_labels) const;
+
+    // Score one dense row: proba_out receives the mean class distribution
+    // (get_num_classes() values), the majority-vote class is returned.
+    // Runs on the calling thread and does not allocate in steady state.
+    int predict_row(const double* row, double* proba_out) const;
+};
+
+#endif // FLAT_FOREST_HPP
@@ -0,0 +1,88 @@
+#ifndef GRID_SEARCH_HPP
+#define GRID_SEARCH_HPP
+
+#include "decision_tree.hpp"
+#include "random_forest.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Values to try for each tunable field (the grid is their cartesian product)
+struct search_space {
+    // tree_hyperparameters
+    vector<int> max_depth = {-1};
+    vector<int> min_examples_per_leaf = {1};
+
+    // tree_growing_config (untuned fields, e.g. weighting, are copied from base_growing)
+    vector<tree_growing_config::SplitCriterion> criterion = {tree_growing_config::SplitCriterion::GINI};
+    tree_growing_config base_growing;
+
+    // random_forest_config (untuned fields, e.g. the seed, are copied from base_forest)
+    vector<int> num_trees = {100};
+    vector<double> bootstrap_sample_ratio = {1.0};
+    random_forest_config base_forest;
+};
+
+// Configuration for the search process itself
+struct grid_search_config {
+    int num_folds = 3;                 // k in k-fold cross-validation (>= 2)
+    unsigned int fold_seed = 42;       // Seed for shuffling rows into folds
+
+    int num_random_candidates = -1;    // -1 = full grid, otherwise random search over this many grid points
+    unsigned int random_seed = 42;     // Seed for picking random candidates
+
+    // Successive halving: every rung grows survivors (warm start) to halving_factor times
+    // more trees and keeps only the best 1/halving_factor of them
+    bool use_successive_halving = true;
+    int halving_factor = 3;            // eta
+    int min_trees = 10;                // Tree budget of the first rung
+};
+
+// One point of the search space, with the full configs used to train it
+struct search_candidate {
+    tree_hyperparameters hp;
+    tree_growing_config growing;
+    random_forest_config forest;
+
+    string describe() const;
+};
+
+// Cross-validated score of one candidate at one rung
+struct search_result {
+    int candidate_idx;
+    search_candidate candidate;
+    int rung;
+    int trees_trained;                 // Tree budget used at this rung
+    vector<double> fold_accuracies;
+    double mean_accuracy;
+    double stddev_accuracy;
+    double train_time_ms;              // Summed over folds, trees added at this rung only
+    bool eliminated;                   // Dropped by successive halving after this rung
+};
+
+// Parallel grid / random search over tree and forest hyperparameters.
+// (candidate x fold) jobs are scheduled dynamically on the OpenMP thread pool and all
+// share one loaded data_frame; folds are index views over it, so nothing is copied.
+class grid_search {
+public:
+    grid_search_config* search_config = nullptr;
+
+    // Optional callback, invoked (serialized) as soon as all folds of a candidate finish
+    function<void(const search_result&)> on_result;
+
+    // Expand a search space into its candidate list
+    static vector<search_candidate> enumerate(const search_space& space);
+
+    // Run the search; returns the last result of every candidate, best first
+    vector<search_result> run(
+        const data_frame& df,
+        const vector<string>& feature_cols,
+        const string& target_col,
+        const search_space& space
+    );
+};
+
+#endif // GRID_SEARCH_HPP
@@ -1,13 +1,38 @@
 #ifndef LOADERS_H
 #define LOADERS_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
 #include <map>
+#include <fstream>
 
 using namespace std;
 
+// Which rows of a numeric column hold a value (one bit per row, set = present).
+// Stays empty while nothing is missing, so complete columns pay nothing.
+class validity_bitmap {
+private:
+    vector<uint64_t> words;
+    size_t num_missing = 0;
+    
+public:
+    validity_bitmap() = default;
+    explicit validity_bitmap(const vector<bool>& missing);
+    
+    bool is_valid(size_t index) const {
+        return words.empty() || ((words[index >> 6] >> (index & 63)) & 1);
+    }
+    size_t missing_count() const { return num_missing; }
+    
+    // Bitmap of the given rows, in that order
+    validity_bitmap select(const vector<size_t>& indices) const;
+};
+
+// CSV fields that mean "no value" in numeric columns: empty, NA, N/A, NaN, null, ?
+bool is_missing_value(const string& field);
+
 // Base column class
 class col {
 public:
@@ -36,6 +61,7 @@ public:
     
     // Encoding API
     void fit_encoding() const;  // Build encoding from unique values in data
+    void set_encoding(const vector<string>& categories) const;  // Use a known category list (sorted, as fit_encoding would build)
     int encode(const string& value) const;  // Convert string -> int (throws if not found)
     string decode(int idx) const;  // Convert int -> string (throws if out of range)
     int get_encoded(size_t index) const;  // Get encoded value at row index
@@ -47,38 +73,65 @@ public:
     string get_type() const override;
 };
 
-// Integer column implementation
+// Integer column implementation (missing values read as 0; check is_missing)
 class int_col : public col {
 private:
     vector<int> data;
+    validity_bitmap validity;
     
 public:
-    explicit int_col(const vector<int>& values);
+    explicit int_col(const vector<int>& values, validity_bitmap validity = validity_bitmap());
     
     int get(size_t index) const;
     const vector<int>& get_data() const;
+    bool is_missing(size_t index) const { return !validity.is_valid(index); }
+    size_t missing_count() const { return validity.missing_count(); }
+    const validity_bitmap& get_validity() const { return validity; }
     
     unique_ptr<col> clone() const override;
     size_t size() const override;
     string get_type() const override;
 };
 
-// Float column implementation
+// Float column implementation (missing values are NaN in the data and unset in the bitmap;
+// NaNs passed to the constructor are marked missing)
 class float_col : public col {
 private:
     vector<double> data;
+    validity_bitmap validity;
     
 public:
     explicit float_col(const vector<double>& values);
     
     double get(size_t index) const;
     const vector<double>& get_data() const;
+    bool is_missing(size_t index) const { return !validity.is_valid(index); }
+    size_t missing_count() const { return validity.missing_count(); }
+    const validity_bitmap& get_validity() const { return validity; }
     
     unique_ptr<col> clone() const override;
     size_t size() const override;
     string get_type() const override;
 };
 
+// Infer a column type ("int", "float" or "string") from raw CSV fields (missing values fit any type)
+string infer_column_type(const vector<string>& values);
+
+// Reads a CSV file a chunk of rows at a time, so large files never have to sit in memory at once
+class csv_chunk_reader {
+private:
+    ifstream file;
+    vector<string> headers;
+    
+public:
+    explicit csv_chunk_reader(const string& path);
+    
+    const vector<string>& get_headers() const;
+    
+    // Read up to max_rows rows into rows (cleared first); returns number of rows read, 0 at end of file
+    size_t read_chunk(vector<vector<string>>& rows, size_t max_rows);
+};
+
 // Import CSV files and store efficiently as a dataframe
 // Designed for parallel read access after initialization (training decision trees and random forests)
 // Supports column data types: string, int, and float
@@ -99,6 +152,17 @@ public:
     // Import from CSV file - returns a new data_frame
     static data_frame import_from(const string& path);
     
+    // Build from parsed CSV rows. column_types forces "int"/"float"/"string" per column
+    // (nullptr = infer from the rows), so chunks of one file can share a schema.
+    static data_frame from_rows(
+        const vector<string>& headers,
+        const vector<vector<string>>& rows,
+        const vector<string>* column_types = nullptr
+    );
+    
+    // Append a column (its size must match the existing columns)
+    void add_column(const string& name, unique_ptr<col> column);
+    
     // Get a column by name (returns nullptr if not found)
     const col* get_column(const string& name) const;
     
@@ -121,6 +185,9 @@ public:
     // Get a subset of rows (used internally for train_test_split)
     data_frame get_rows(const vector<size_t>& indices) const;
     
+    // Indices of the rows that have a value in column (all rows for string columns)
+    vector<size_t> present_rows(const string& column_name) const;
+    
     // Print basic info about the dataframe
     void print_info() const;
     
@@ -1,11 +1,74 @@
 #ifndef METRICS_H
 #define METRICS_H
 
+#include <ostream>
+#include <string>
 #include <vector>
 #include "loaders.hpp"
 
 using namespace std;
 
+// Counts of (true class, predicted class) pairs, row-major by true class
+struct confusion_matrix {
+    int num_classes = 0;
+    vector<size_t> counts;     // counts[truth * num_classes + predicted]
+    vector<size_t> unmatched;  // Per true class: predictions outside [0, num_classes), all misses
+
+    size_t at(int truth, int predicted) const { return counts[(size_t)truth * num_classes + predicted]; }
+    size_t total() const;
+};
+
+// Per-class scores (0 where undefined: the class was never predicted / never occurs)
+struct class_report {
+    size_t support = 0;        // Rows whose true class is this one
+    size_t predicted = 0;      // Rows predicted as this class
+    double precision = 0.0;
+    double recall = 0.0;
+    double f1_score = 0.0;
+};
+
+// Everything derived from one confusion matrix.
+// Macro precision (recall) averages the classes that were predicted (occur),
+// as metrics::precision / metrics::recall always have; macro F1 is the mean
+// per-class F1. Micro scores equal accuracy for single-label data.
+struct classification_report {
+    size_t rows = 0;
+    double accuracy = 0.0;
+    double macro_precision = 0.0;
+    double macro_recall = 0.0;
+    double macro_f1 = 0.0;
+    double micro_precision = 0.0;
+    double micro_recall = 0.0;
+    double micro_f1 = 0.0;
+    double weighted_precision = 0.0;   // Weighted by support
+    double weighted_recall = 0.0;
+    double weighted_f1 = 0.0;
+    vector<class_report> per_class;
+};
+
+// Scores of a probability matrix (proba[row][class], as predict_proba returns).
+// AUCs are one-vs-rest per class; NaN where a class has no positive or no
+// negative rows, and such classes are left out of the macro averages.
+struct probability_report {
+    size_t rows = 0;
+    double log_loss = 0.0;
+    double brier_score = 0.0;          // Mean over rows of sum_c (p_c - [c == label])^2
+    double macro_roc_auc = 0.0;
+    double macro_pr_auc = 0.0;         // PR-AUC as average precision
+    vector<double> roc_auc;            // Per class
+    vector<double> pr_auc;
+    bool approximate = false;          // AUCs from a score histogram instead of a sort
+};
+
+// Regression scores of predicted against true values
+struct regression_report {
+    size_t rows = 0;
+    double mean_squared_error = 0.0;
+    double root_mean_squared_error = 0.0;
+    double mean_absolute_error = 0.0;
+    double r2 = 0.0;                   // 1 - SSE / total sum of squares (0 if the truth is constant)
+};
+
 class metrics {
 public:
     /*
@@ -51,15 +114,105 @@ public:
         int num_classes
     );
     
+    // Weighted counterparts on class distributions given as summed row weights
+    // (class_weights[c] = total weight of class c rows). With unit weights they
+    // equal the label-based versions exactly.
+    static double gini_impurity(const vector<double>& class_weights);
+    static double shannon_entropy(const vector<double>& class_weights);
+    
+    static double gini_gain(
+        const vector<double>& parent_weights,
+        const vector<double>& left_weights,
+        const vector<double>& right_weights
+    );
+    
+    static double entropy_gain(
+        const vector<double>& parent_weights,
+        const vector<double>& left_weights,
+        const vector<double>& right_weights
+    );
+    
+    // Summed weight of each class (labels outside [0, num_classes) are ignored)
+    static vector<double> weighted_class_counts(
+        const vector<int>& labels,
+        const vector<double>& weights,
+        int num_classes
+    );
+    
     /* 
         Performance metrics
     */
     
+    // Confusion matrix in one parallel pass (thread-local matrices, merged once).
+    // num_classes <= 0 derives it from the largest label, as precision / recall
+    // always have; predictions outside the classes count as misses of the true
+    // class. Throws on labels outside [0, num_classes).
+    static confusion_matrix confusion(
+        const vector<int>& predictions, 
+        const vector<int>& labels,
+        int num_classes = 0
+    );
+    
+    // Accuracy, macro/micro/weighted averages and per-class scores
+    static classification_report report(const confusion_matrix& matrix);
+    
+    static classification_report report(
+        const vector<int>& predictions, 
+        const vector<int>& labels,
+        int num_classes = 0
+    );
+    
+    // Per-class table plus the averages (class_names[c] labels row c if given)
+    static void print_report(
+        const classification_report& report,
+        ostream& out,
+        const vector<string>& class_names = {}
+    );
+    
+    // Mean negative log-likelihood of the true class (probabilities clipped to [eps, 1 - eps])
+    static double log_loss(
+        const vector<vector<double>>& probabilities,
+        const vector<int>& labels,
+        double eps = 1e-15
+    );
+    
+    static double brier_score(
+        const vector<vector<double>>& probabilities,
+        const vector<int>& labels
+    );
+    
+    // Log-loss, Brier score and one-vs-rest ROC-AUC / PR-AUC in parallel passes.
+    // auc_bins == 0 ranks rows exactly (parallel merge sort per class, ties
+    // count half); auc_bins > 0 counts scores into that many equal-width bins
+    // of [0, 1] instead (one pass, no sort; error shrinks with the bin width).
+    static probability_report probability_scores(
+        const vector<vector<double>>& probabilities,
+        const vector<int>& labels,
+        size_t auc_bins = 0
+    );
+    
+    // Per-class AUC table plus log-loss and Brier score
+    static void print_probability_report(
+        const probability_report& report,
+        ostream& out,
+        const vector<string>& class_names = {}
+    );
+    
+    // MSE, RMSE, MAE and R^2 in one parallel pass (after the mean of the truth)
+    static regression_report regression_scores(
+        const vector<double>& predictions,
+        const vector<double>& truth
+    );
+    
+    static void print_regression_report(const regression_report& report, ostream& out);
+    
     static double accuracy(
         const vector<int>& predictions, 
         const vector<int>& labels
     );
 
+    // precision / recall / f1_score build one report each; when several scores
+    // are needed, build the report once and read them from it
     static double precision(
         const vector<int>& predictions, 
         const vector<int>& labels
@@ -70,10 +223,14 @@ public:
         const vector<int>& labels
     );
 
+    // Harmonic mean of macro precision and recall (kept for comparability
+    // with earlier results; see classification_report::macro_f1)
     static double f1_score(
         const vector<int>& predictions, 
         const vector<int>& labels
     );
+    
+    static double f1_score(const classification_report& report);
 };
 
 #endif // METRICS_H
\ No newline at end of file
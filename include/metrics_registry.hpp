@@ -0,0 +1,138 @@
+#ifndef METRICS_REGISTRY_HPP
+#define METRICS_REGISTRY_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Runtime metrics for long training jobs and scoring servers, exported in the
+// Prometheus text format. Updates are a relaxed atomic add on a per-thread shard
+// (each shard alone on a cache line), so hot threads can record freely; only
+// exports walk the shards.
+
+static const int METRIC_SHARDS = 16;
+
+// Shard of the calling thread (threads are assigned round-robin on first use)
+int metric_shard_index();
+
+// Monotonic count (name should end in _total)
+class metric_counter {
+private:
+    struct alignas(64) shard {
+        atomic<uint64_t> value{0};
+    };
+    shard shards[METRIC_SHARDS];
+
+public:
+    void add(uint64_t n = 1) {
+        shards[metric_shard_index()].value.fetch_add(n, memory_order_relaxed);
+    }
+
+    uint64_t value() const;
+};
+
+// Value that goes up and down (queue depths, sizes); last write wins
+class metric_gauge {
+private:
+    atomic<double> current{0.0};
+
+public:
+    void set(double value) { current.store(value, memory_order_relaxed); }
+    double value() const { return current.load(memory_order_relaxed); }
+};
+
+// Distribution over fixed buckets (upper bounds; +Inf is implicit)
+class metric_histogram {
+private:
+    struct alignas(64) shard {
+        unique_ptr<atomic<uint64_t>[]> buckets;   // One per bound, plus +Inf
+        atomic<double> sum{0.0};
+    };
+    vector<double> bounds;
+    unique_ptr<shard[]> shards;
+
+public:
+    explicit metric_histogram(const vector<double>& upper_bounds);
+
+    void observe(double value);
+
+    const vector<double>& get_bounds() const { return bounds; }
+
+    // Per-bucket (non-cumulative) counts, +Inf last, and the sum of observed values
+    void snapshot(vector<uint64_t>& bucket_counts, double& sum) const;
+
+    // Exponential bucket bounds: start, start * factor, ... (count bounds)
+    static vector<double> exponential_bounds(double start, double factor, int count);
+};
+
+// Named metrics. get_* registers on first use and returns the same object afterwards,
+// so call sites can keep a static reference. Metric objects live as long as the registry.
+class metrics_registry {
+private:
+    struct entry {
+        string help;
+        unique_ptr<metric_counter> counter;
+        unique_ptr<metric_gauge> gauge;
+        unique_ptr<metric_histogram> histogram;
+    };
+
+    mutable mutex lock;                // Registration and export only, never updates
+    map<string, entry> metrics;
+
+public:
+    // Process-wide registry used by the library's own instrumentation
+    static metrics_registry& global();
+
+    // Throws invalid_argument if name is already registered as another kind
+    metric_counter& get_counter(const string& name, const string& help);
+    metric_gauge& get_gauge(const string& name, const string& help);
+    metric_histogram& get_histogram(const string& name, const string& help, const vector<double>& upper_bounds);
+
+    // Prometheus text exposition format (version 0.0.4)
+    void write_prometheus(ostream& out) const;
+
+    // Write to path via a temporary file and rename, so scrapers never see a partial file
+    void write_prometheus_file(const string& path) const;
+};
+
+// Publishes a registry while a job runs: rewrites file_path every interval_ms and/or
+// answers GET /metrics on 127.0.0.1:http_port, from one background thread.
+class metrics_exporter {
+private:
+    thread worker;
+    mutex wake_lock;
+    condition_variable wake;
+    bool stop_requested = false;
+    int listen_fd = -1;
+
+    void open_listener();
+    void serve_pending_requests();
+
+public:
+    const metrics_registry* source = &metrics_registry::global();
+    string file_path;                  // Empty = no file
+    int http_port = 0;                 // 0 = no HTTP endpoint
+    int interval_ms = 1000;            // File rewrite period (also the HTTP poll period)
+
+    metrics_exporter() = default;
+    metrics_exporter(const metrics_exporter&) = delete;
+    metrics_exporter& operator=(const metrics_exporter&) = delete;
+    ~metrics_exporter();
+
+    // Throws if the HTTP port cannot be bound; no-op if neither output is set
+    void start();
+
+    // Stop the thread and write the file one last time
+    void stop();
+};
+
+#endif // METRICS_REGISTRY_HPP
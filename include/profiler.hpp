@@ -0,0 +1,79 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+using namespace std;
+
+// Training phases timed by the profiler (inclusive: SORT and SPLIT_SCORING run inside SPLIT_SEARCH)
+enum class profile_phase {
+    TREE_FIT,          // Growing one tree (decision_tree::fit, per tree of a forest)
+    BOOTSTRAP,         // Drawing one tree's bootstrap sample
+    NODE_ALLOC,        // Allocating a node and filling in a leaf
+    LABEL_GATHER,      // Collecting the encoded labels of a node's rows
+    SPLIT_SEARCH,      // Best split over all features of a node
+    SORT,              // Gathering and sorting one numeric feature's values
+    SPLIT_SCORING,     // Evaluating candidate split gains of one feature
+    PARTITION,         // Splitting a node's rows into left/right
+    TASK_WAIT,         // Waiting for child subtree tasks
+    COUNT
+};
+
+// Low-overhead, per-thread phase timer. Compiled in only with -DPRF_PROFILE
+// (CMake option PRF_PROFILE); otherwise PRF_PROFILE_SCOPE expands to nothing.
+// Each thread writes only its own slot (registered once, under a lock), so
+// recording is contention-free; reports aggregate all slots and must not run
+// while profiled code is running.
+namespace profiler {
+    constexpr bool is_enabled() {
+#ifdef PRF_PROFILE
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Nanoseconds since the profiler epoch (first use)
+    int64_t now_ns();
+
+    // Record one finished interval of phase on the calling thread
+    void record(profile_phase phase, int64_t start_ns, int64_t end_ns);
+
+    // Forget everything recorded so far
+    void reset();
+
+    // Per-phase table: calls, total time, share of TREE_FIT time, busiest thread
+    void print_breakdown(ostream& out);
+
+    // Chrome trace (chrome://tracing, Perfetto) with one event per recorded interval
+    // (at most 1M per thread, later ones are only counted in the breakdown)
+    void write_chrome_trace(const string& path);
+}
+
+// Times the enclosing scope as one interval of phase
+class profile_scope {
+private:
+    profile_phase phase;
+    int64_t start_ns;
+
+public:
+    explicit profile_scope(profile_phase phase) : phase(phase), start_ns(profiler::now_ns()) {}
+    ~profile_scope() { profiler::record(phase, start_ns, profiler::now_ns()); }
+
+    profile_scope(const profile_scope&) = delete;
+    profile_scope& operator=(const profile_scope&) = delete;
+};
+
+#define PRF_PROFILE_CONCAT_(a, b) a##b
+#define PRF_PROFILE_CONCAT(a, b) PRF_PROFILE_CONCAT_(a, b)
+
+#ifdef PRF_PROFILE
+#define PRF_PROFILE_SCOPE(phase) profile_scope PRF_PROFILE_CONCAT(prf_profile_scope_, __LINE__)(profile_phase::phase)
+#else
+#define PRF_PROFILE_SCOPE(phase) ((void)0)
+#endif
+
+#endif // PROFILER_HPP
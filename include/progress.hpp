@@ -2,38 +2,73 @@
 #define PROGRESS_HPP
 
 #include <atomic>
-#include <omp.h>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 using namespace std;
 
-// Progress tracker for a single decision tree
+// Counters of one worker thread, alone on a cache line so threads never share one.
+// Workers only do relaxed increments; readers sum all slots.
+struct alignas(64) ProgressSlot {
+    atomic<long long> nodes_in_flight{0};   // Nodes of trees this thread has not finished yet
+    atomic<int> trees_completed{0};
+};
+
+// Slot table shared by the trees of one forest. A thread claims a slot index the
+// first time it reports (indices wrap around past MAX_SLOTS threads, which only
+// makes two threads share a line; slots are only ever added to or subtracted
+// from, so no count is lost). Only the sum over slots is meaningful.
+struct ProgressSlots {
+    static const int MAX_SLOTS = 64;
+    ProgressSlot slots[MAX_SLOTS];
+    
+    ProgressSlot& local();          // The calling thread's slot
+    void reset();
+    long long total_nodes_in_flight() const;
+    int total_trees_completed() const;
+};
+
+// Progress tracker for a single decision tree (standalone, or one tree of a forest)
 struct TreeProgress {
-    atomic<int> nodes_created;
-    int estimated_total_nodes;
+    ProgressSlots* slots;           // The forest's slots, or own_slots when standalone
+    unique_ptr<ProgressSlots> own_slots;  // Allocated by initialize() if no forest set slots
+    long long estimated_total_nodes;
+    atomic<long long> nodes_counted{0};  // This tree's nodes in the slots, from every thread
     
     TreeProgress();
     
     // Initialize with estimate based on hyperparameters
     void initialize(int max_depth, int min_samples_per_leaf, size_t n_samples);
     
+    // Relaxed increments of the calling thread's slot and of this tree's count (no lock;
+    // only threads growing the same tree share the count's line)
     void increment_nodes();
     
     double get_progress() const;
     
+    // Called by the thread that fitted the tree: removes all of this tree's nodes, from
+    // whichever threads counted them, from the in-flight total (standalone trees also
+    // count themselves as completed)
     void mark_complete();
 };
 
-// Progress tracker for random forest
+// Progress tracker for random forest. Workers only bump their own ProgressSlot;
+// a reporter thread started by initialize() samples the slots every
+// report_interval_ms and is the only writer to the console until finish().
 struct RandomForestProgress {
-    atomic<int> trees_completed;
     int total_trees;
-    TreeProgress* tree_progresses;  // Array of per-tree progress
-    omp_lock_t output_lock;         // Lock for thread-safe console output
+    long long estimated_total_nodes;   // Sum of the per-tree estimates
+    TreeProgress* tree_progresses;     // Array of per-tree progress (estimates only)
+    ProgressSlots slots;
+    int report_interval_ms = 100;
     
     RandomForestProgress();
     
     ~RandomForestProgress();
     
+    // Reset counters and start the reporter thread
     void initialize(int num_trees);
     
     void initialize_tree(int tree_idx, int max_depth, int min_samples_per_leaf, size_t n_samples);
@@ -42,12 +77,24 @@ struct RandomForestProgress {
     
     void mark_tree_complete(int tree_idx);
     
+    // Lock-free snapshot: completed trees, plus in-flight nodes against the
+    // average per-tree estimate (capped at 99% of the unfinished trees)
     double get_overall_progress() const;
     
-    // Thread-safe progress display
+    // Draw the bar if the percentage changed (reporter thread and finish() only)
     void print_progress(bool force_print = false);
     
+    // Stop the reporter and draw the final bar
     void finish();
+    
+private:
+    thread reporter;
+    mutex reporter_lock;               // Guards stop_requested (reporter wake-up only)
+    condition_variable reporter_wake;
+    bool stop_requested = false;
+    int last_percent = -1;
+    
+    void stop_reporter();
 };
 
-#endif // PROGRESS_HPP
\ No newline at end of file
+#endif // PROGRESS_HPP
@@ -2,9 +2,13 @@
 #define RANDOM_FOREST_H
 
 #include "decision_tree.hpp"
+#include "flat_forest.hpp"
+#include "compact_forest.hpp"
 #include "progress.hpp"
 #include <vector>
 
+class columnar_file;
+
 using namespace std;
 
 // Random forest specific configuration
@@ -13,12 +17,47 @@ struct random_forest_config {
     double bootstrap_sample_ratio = 1.0;    // Ratio of samples to use (1.0 = 100% of data)
     unsigned int random_seed = 42;          // Seed for reproducible bootstrap sampling
     bool use_parallel = true;               // Enable forest-level parallelism (training and prediction)
+    size_t max_samples_per_tree = 0;        // Cap on bootstrap size (0 = no cap); bounds out-of-core memory
+};
+
+// Permutation importance: score lost when one feature's values are
+// shuffled across rows (features in get_feature_names() order)
+struct permutation_result {
+    size_t rows = 0;
+    int num_repeats = 0;
+    double baseline_score = 0.0;       // Accuracy (classification) or R^2 (regression)
+    vector<double> mean_decrease;
+    vector<double> stddev_decrease;    // Over the repeats
 };
 
 class random_forest {
 private:
     vector<decision_tree> trees;
-    int num_classes;  // Number of unique classes (learned during fit)
+    int num_classes;  // Number of unique classes (learned during fit; 1 for regression)
+    bool regression = false;  // float target: leaves hold means, predictions are tree averages
+    
+    // Learned during fit (reused by add_trees)
+    vector<string> feature_names;
+    vector<string> feature_types;   // Column type of each feature ("int", "float" or "string")
+    string target_column_name;
+    vector<string> class_labels;    // Decoded class names (empty for int targets)
+    vector<vector<string>> feature_categories;  // Sorted categories of string features (empty for numeric)
+    
+    // Flattened copy of the trees for single-row inference (kept in sync by fit/add_trees)
+    flat_forest compiled;
+    
+    // Mean of the trees' impurity importances (saved with the model)
+    vector<double> impurity_importances;
+    
+    // Recompute impurity_importances from the trees
+    void update_importances();
+    
+    // Target classes of X's rows in this forest's encoding (-1 = unknown label;
+    // empty if X has no target column)
+    vector<int> target_classes(const data_frame& X) const;
+    
+    // Regression targets of X's rows (empty if X has no target column)
+    vector<double> target_values(const data_frame& X) const;
     
     // Generate bootstrap sample (sampling with replacement)
     vector<size_t> generate_bootstrap_sample(
@@ -27,6 +66,28 @@ private:
         unsigned int seed
     ) const;
     
+    // Reject bad class weights / weight column type before trees are fitted in
+    // parallel regions (weight_type: the weight column's type, "" if unweighted)
+    void check_weighting(const string& weight_type) const;
+    
+    // check_weighting plus the sample weight values of the training rows (nullptr = all
+    // rows): rejects missing, negative, NaN or infinite weights and returns their sum
+    // (first_row: file row of df's first row, for error messages)
+    double check_row_weights(const data_frame& df, const vector<size_t>* row_indices, size_t first_row = 0) const;
+    
+    // Bootstrap sample size for n_samples training rows
+    size_t bootstrap_size(size_t n_samples) const;
+    
+    // Gather rows of X as dense feature vectors (forest feature order) for the flattened model
+    vector<double> gather_dense_rows(const data_frame& X, const vector<size_t>& row_indices) const;
+    
+    // Train num_new_trees more trees, continuing the seed sequence
+    void train_trees(
+        const data_frame& df,
+        int num_new_trees,
+        const vector<size_t>* row_indices
+    );
+    
 public:
     // Shared config pointers across all trees
     tree_hyperparameters* hp_config = nullptr;
@@ -38,14 +99,99 @@ public:
     void fit(
         const data_frame& df,
         const vector<string>& feature_cols,
+        const string& target_col,
+        const vector<size_t>* row_indices = nullptr  // nullptr = bootstrap from all rows
+    );
+    
+    // Out-of-core training: each tree's bootstrap is streamed out of a memory-mapped
+    // columnar file into a private data_frame that is freed once the tree is built.
+    // Peak memory ~ (concurrent trees) x (bootstrap rows), independent of file size.
+    void fit_out_of_core(
+        const columnar_file& file,
+        const vector<string>& feature_cols,
         const string& target_col
     );
     
+    // Warm start: append num_new_trees trees to a fitted forest.
+    // df (and row_indices) must be the data the forest was fitted on.
+    void add_trees(
+        const data_frame& df,
+        int num_new_trees,
+        const vector<size_t>* row_indices = nullptr
+    );
+    
+    // Number of trees available for prediction
+    int get_num_trees() const;
+    
+    // Save the fitted forest (flattened trees + schema) to a binary model file.
+    // A loaded forest predicts like the original but cannot be grown with add_trees.
+    void save(const string& path) const;
+    static random_forest load(const string& path);
+    
+    // Compact 16-bit serving variant of the fitted forest
+    compact_forest compact() const;
+    
+    // Score X with both the full-precision and the compact model and compare them
+    // (accuracy too when X has the target column)
+    compact_check check_compact(const compact_forest& model, const data_frame& X) const;
+    
+    // Write the forest as generated C++ (header-only scorer, also buildable as a
+    // shared object); function names are prefixed with name
+    void export_cpp(const string& path, const string& name) const;
+    
+    // Schema learned during fit
+    bool is_regressor() const;
+    int get_num_classes() const;
+    const vector<string>& get_feature_names() const;
+    const vector<string>& get_feature_types() const;
+    
+    // Original target value of an encoded class (the number itself for int targets)
+    string get_class_label(int class_idx) const;
+    
+    // Mean decrease in impurity per feature, averaged over the trees (sums to 1;
+    // empty for model files saved before importances were recorded)
+    const vector<double>& feature_importances() const;
+    
+    // Permutation importance on X (which must have the target column); the
+    // score is accuracy, or R^2 for regression (rows with a missing or unseen
+    // target are skipped).
+    // Each (feature, repeat) task scores all rows with the batched flattened
+    // scorer, substituting the feature's values through a shuffled row
+    // index; X is gathered into dense rows once and never copied per task.
+    // Tasks run in parallel.
+    permutation_result permutation_importance(const data_frame& X, int num_repeats = 5, unsigned int seed = 42) const;
+    
+    // Out-of-bag accuracy on the training data (same df/row_indices as fit)
+    double oob_accuracy(const data_frame& df, const vector<size_t>* row_indices = nullptr) const;
+    
     // Prediction via majority voting (parallel)
     vector<int> predict(const data_frame& X) const;
     
-    // Prediction probabilities - average across all trees (parallel)
-    vector<vector<double>> predict_proba(const data_frame& X) const;
+    // Low-latency prediction of one dense row: features in get_feature_names() order,
+    // categorical features as encode_category() codes. proba_out receives
+    // get_num_classes() averaged probabilities; returns the majority-vote class.
+    // Runs on the calling thread (no parallel region) and does not allocate.
+    int predict_row(const double* row, double* proba_out) const;
+    
+    // Batch of dense rows stored back to back (row-major); classes_out holds
+    // n_rows classes, proba_out n_rows x get_num_classes() probabilities.
+    // Shallow numeric-only forests (depth <= 10) take a branch-free blocked path.
+    void predict_rows(const double* rows, size_t n_rows, int* classes_out, double* proba_out) const;
+    
+    // Category code of a value of categorical feature feature_idx (-1 if unseen)
+    double encode_category(int feature_idx, const string& value) const;
+    
+    // Prediction for a subset of rows of X (e.g. a held-out fold)
+    vector<int> predict(const data_frame& X, const vector<size_t>& row_indices) const;
+    
+    // Prediction probabilities - average across all trees (parallel); classes, if
+    // given, receives each row's predicted class from the same traversal
+    vector<vector<double>> predict_proba(const data_frame& X, vector<int>* classes = nullptr) const;
+    
+    // Regression prediction: mean of the trees' leaf values (parallel, flattened forest).
+    // Classification-only calls (predict, oob_accuracy, compact) throw on a regressor;
+    // predict_row / predict_rows return the value as the single "probability".
+    vector<double> predict_values(const data_frame& X) const;
 };
 
 #endif // RANDOM_FOREST_H
@@ -0,0 +1,39 @@
+#ifndef SCORING_HPP
+#define SCORING_HPP
+
+#include "random_forest.hpp"
+
+#include <string>
+
+using namespace std;
+
+// Configuration for the streaming batch scorer
+struct scoring_config {
+    size_t chunk_rows = 8192;          // Rows parsed and predicted per block
+    size_t queue_capacity = 4;         // Blocks in flight between two stages
+    bool write_probabilities = false;  // Also write one probability column per class
+};
+
+// What a scoring run did, and where its time went
+struct scoring_stats {
+    size_t rows_scored = 0;
+    size_t chunks = 0;
+    double parse_ms = 0.0;             // Busy time of each stage
+    double predict_ms = 0.0;
+    double write_ms = 0.0;
+    double wall_ms = 0.0;              // End-to-end (stages overlap, so < sum of the above)
+};
+
+// Scores a CSV file of any size with a fitted forest in constant memory.
+// Three stages run concurrently, connected by bounded queues:
+//   parse chunk (reader thread) -> predict block (caller, OpenMP) -> write output (writer thread)
+// Only the feature columns the forest was trained on are parsed.
+class batch_scorer {
+public:
+    const random_forest* forest = nullptr;
+    scoring_config* config = nullptr;
+
+    scoring_stats run(const string& input_csv, const string& output_path) const;
+};
+
+#endif // SCORING_HPP
@@ -0,0 +1,115 @@
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include "random_forest.hpp"
+#include "bounded_queue.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Configuration for the scoring daemon
+struct server_config {
+    string socket_path;                // Unix domain socket path (used when tcp_port == 0)
+    int tcp_port = 0;                  // > 0: listen on 127.0.0.1:tcp_port instead
+    size_t max_batch_rows = 64;        // Requests coalesced into one micro-batch
+    int max_wait_us = 200;             // Longest the first request of a batch waits for company
+    size_t queue_capacity = 4096;      // Pending requests before clients are back-pressured
+    size_t latency_window = 65536;     // Most recent request latencies kept for percentiles
+};
+
+// Snapshot of what the daemon has served so far
+struct server_stats {
+    size_t requests = 0;
+    size_t batches = 0;
+    double mean_batch_rows = 0.0;
+    double p50_latency_us = 0.0;       // Enqueue -> prediction ready, over the latency window
+    double p99_latency_us = 0.0;
+    double throughput_rps = 0.0;       // Requests per second since run() started
+};
+
+// Serves predictions of a loaded forest over a local socket.
+// Line protocol, one request per line:
+//   PREDICT v1,v2,...   -> OK <label> p0,p1,...   (values in get_feature_names() order)
+//                          (NA or an empty field = missing numeric value)
+//   INFO                -> OK features=... classes=... trees=N
+//   STATS               -> OK requests=... batches=... mean_batch=... p50_us=... p99_us=... rps=...
+//   SHUTDOWN            -> OK (then the server stops)
+// Errors are answered with "ERR <message>" and keep the connection open.
+// Every connection gets a thread; one batcher thread coalesces concurrent
+// requests into micro-batches for random_forest::predict_rows.
+class scoring_server {
+private:
+    // One PREDICT in flight; the connection thread waits until done is set
+    struct pending_request {
+        vector<double> row;
+        int predicted_class = 0;
+        vector<double> probabilities;
+        chrono::steady_clock::time_point received;
+        bool done = false;
+        mutex lock;
+        condition_variable ready;
+    };
+
+    unique_ptr<bounded_queue<pending_request*>> queue;  // Created by run() with config->queue_capacity
+    atomic<bool> stopping{false};
+    int listen_fd = -1;
+
+    mutable mutex clients_lock;
+    set<int> client_fds;
+    vector<thread::id> finished_clients;  // Connection threads about to return; joined by run()
+
+    // Written by the batcher thread, read by get_stats()
+    mutable mutex stats_lock;
+    size_t total_requests = 0;
+    size_t total_batches = 0;
+    vector<double> latencies_us;       // Ring buffer of config->latency_window entries
+    size_t latency_next = 0;
+    chrono::steady_clock::time_point started;
+
+    void open_listener();
+    void batch_loop();
+    void serve_client(int fd);
+    string handle_line(const string& line);
+
+public:
+    const random_forest* forest = nullptr;
+    server_config* config = nullptr;
+
+    // Accepts connections until stop() or a SHUTDOWN request (blocks the caller)
+    void run();
+    void stop();
+
+    server_stats get_stats() const;
+};
+
+// Load generator: num_clients connections send PREDICT requests built from real CSV rows
+struct load_test_config {
+    string socket_path;                // Same endpoint rules as server_config
+    int tcp_port = 0;
+    string csv_path;                   // Rows to send (must contain the forest's feature columns)
+    int num_clients = 8;
+    int requests_per_client = 1000;
+};
+
+struct load_test_result {
+    size_t requests = 0;
+    size_t errors = 0;                 // ERR responses
+    double wall_ms = 0.0;
+    double throughput_rps = 0.0;
+    double p50_latency_us = 0.0;       // Client-observed round trip
+    double p99_latency_us = 0.0;
+    double max_latency_us = 0.0;
+};
+
+load_test_result run_load_test(const load_test_config& config);
+
+#endif // SERVER_HPP
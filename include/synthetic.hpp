@@ -0,0 +1,37 @@
+#ifndef SYNTHETIC_HPP
+#define SYNTHETIC_HPP
+
+#include "loaders.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Shape of a generated classification data set
+struct synthetic_config {
+    size_t num_rows = 100000;             // Up to 10^8 (memory: ~8 bytes per numeric cell)
+    int num_numeric_features = 10;        // float columns num_0, num_1, ...
+    int num_categorical_features = 0;     // string columns cat_0, cat_1, ... (values "c0", "c1", ...)
+    int categories_per_feature = 8;
+    int num_classes = 2;                  // int target column "label" (0 .. num_classes - 1)
+    double class_separation = 1.0;        // Spread of the class centers, in feature standard deviations
+    double noise = 0.1;                   // Fraction of labels replaced by a uniformly random class
+    double imbalance = 1.0;               // Frequency ratio of the most to the least common class (1 = balanced)
+    unsigned int seed = 42;
+};
+
+// Name of the generated target column
+extern const string SYNTHETIC_TARGET;
+
+// Feature column names, in column order
+vector<string> synthetic_feature_names(const synthetic_config& config);
+
+// Generate the data set directly in memory (no CSV round-trip). Each class has a
+// random center per numeric feature (rows are the center plus unit Gaussian noise)
+// and a preferred category per categorical feature (drawn half of the time).
+// Rows are generated in parallel, in fixed-size blocks seeded from config.seed,
+// so the result is the same for any thread count.
+data_frame make_synthetic(const synthetic_config& config);
+
+#endif // SYNTHETIC_HPP
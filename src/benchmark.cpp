@@ -1,14 +1,48 @@
 #include "benchmark.hpp"
 #include "decision_tree.hpp"
 #include "random_forest.hpp"
+#include "grid_search.hpp"
+#include "cross_validation.hpp"
 #include "metrics.hpp"
 #include "progress.hpp"
+#include "profiler.hpp"
 #include <iostream>
 #include <iomanip>
 #include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <omp.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
 
 using namespace std;
 
+// Helper: Milliseconds since start
+static double elapsed_ms(chrono::high_resolution_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+}
+
+// Helper: Number with fixed decimals (for columns with a unit suffix)
+static string to_string_fixed(double value, int decimals) {
+    ostringstream text;
+    text << fixed << setprecision(decimals) << value;
+    return text.str();
+}
+
+// Print the training profile of the last run (only in -DPRF_PROFILE builds)
+static void report_profile() {
+    if (!profiler::is_enabled()) return;
+    
+    profiler::print_breakdown(cout);
+    profiler::write_chrome_trace("profile_trace.json");
+    cout << "Chrome trace written to profile_trace.json (open in chrome://tracing or ui.perfetto.dev)" << endl;
+}
+
 DatasetConfig get_dataset_config(int datasetChoice) {
     DatasetConfig config;
     
@@ -62,6 +96,9 @@ DatasetConfig get_dataset_config(int datasetChoice) {
         };
         config.target_col = "Class";
         config.needs_encoding = true;  // String target needs encoding
+    } else if (datasetChoice == 4) {
+        // Synthetic dataset (default shape, see synthetic_config)
+        config = get_synthetic_dataset_config(synthetic_config());
     } else {
         cout << "Invalid dataset choice!" << endl;
         exit(1);
@@ -70,6 +107,32 @@ DatasetConfig get_dataset_config(int datasetChoice) {
     return config;
 }
 
+DatasetConfig get_synthetic_dataset_config(const synthetic_config& synthetic) {
+    DatasetConfig config;
+    config.path = "synthetic:" + to_string(synthetic.num_rows) + "x" +
+                  to_string(synthetic.num_numeric_features + synthetic.num_categorical_features);
+    config.feature_cols = synthetic_feature_names(synthetic);
+    config.target_col = SYNTHETIC_TARGET;
+    config.needs_encoding = false;  // Int target
+    config.is_synthetic = true;
+    config.synthetic = synthetic;
+    return config;
+}
+
+data_frame load_dataset(const DatasetConfig& dataset_config) {
+    if (dataset_config.is_synthetic) {
+        return make_synthetic(dataset_config.synthetic);
+    }
+    data_frame df = data_frame::import_from(dataset_config.path);
+    
+    // Rows without a target can be neither learned from nor scored
+    vector<size_t> labelled = df.present_rows(dataset_config.target_col);
+    if (labelled.size() < df.get_num_rows()) {
+        df = df.get_rows(labelled);
+    }
+    return df;
+}
+
 void print_benchmark_table(const vector<BenchmarkResult>& results) {
     cout << "\n========================================" << endl;
     cout << "       BENCHMARK RESULTS" << endl;
@@ -78,34 +141,95 @@ void print_benchmark_table(const vector<BenchmarkResult>& results) {
     
     // Header
     cout << left;
-    cout << setw(30) << "Configuration" 
-         << setw(15) << "Time (ms)" 
-         << setw(12) << "Speedup" 
-         << setw(12) << "Accuracy" 
+    cout << setw(36) << "Configuration" 
+         << setw(12) << "Load (ms)" 
+         << setw(12) << "Train (ms)" 
+         << setw(10) << "Speedup" 
+         << setw(16) << "Samples*trees/s" 
+         << setw(14) << "Predict (ms)" 
+         << setw(10) << "Speedup" 
+         << setw(12) << "Rows/s" 
+         << setw(10) << "Accuracy" 
          << endl;
-    cout << string(69, '-') << endl;
+    cout << string(132, '-') << endl;
     
     // Results
     for (const auto& result : results) {
-        cout << setw(30) << result.config_name 
-             << setw(15) << fixed << setprecision(2) << result.training_time_ms 
-             << setw(12) << fixed << setprecision(2) << result.speedup << "x"
-             << setw(12) << fixed << setprecision(4) << result.accuracy 
+        cout << setw(36) << result.config_name 
+             << setw(12) << fixed << setprecision(2) << result.load_time_ms 
+             << setw(12) << fixed << setprecision(2) << result.training_time_ms 
+             << setw(10) << (to_string_fixed(result.speedup, 2) + "x")
+             << setw(16) << fixed << setprecision(0) << result.train_throughput 
+             << setw(14) << fixed << setprecision(2) << result.predict_time_ms 
+             << setw(10) << (to_string_fixed(result.predict_speedup, 2) + "x")
+             << setw(12) << fixed << setprecision(0) << result.predict_throughput 
+             << setw(10) << fixed << setprecision(4) << result.accuracy 
              << endl;
     }
     
-    cout << string(69, '-') << endl;
+    cout << string(132, '-') << endl;
     cout << endl;
 }
 
+// Per-phase speedup of result over baseline (same workload, different parallelism)
+void set_speedups(BenchmarkResult& result, const BenchmarkResult& baseline) {
+    result.speedup = result.training_time_ms > 0 ? baseline.training_time_ms / result.training_time_ms : 0.0;
+    result.predict_speedup = result.predict_time_ms > 0 ? baseline.predict_time_ms / result.predict_time_ms : 0.0;
+}
+
+// Helper: Fill in throughput figures from the phase timings
+static void set_throughput(BenchmarkResult& result) {
+    if (result.training_time_ms > 0) {
+        result.train_throughput = (double)result.train_samples * result.num_trees / (result.training_time_ms / 1000.0);
+    }
+    if (result.predict_time_ms > 0) {
+        result.predict_throughput = result.test_samples / (result.predict_time_ms / 1000.0);
+    }
+}
+
+// Helper: Accuracy, macro precision/recall and F1 from one confusion matrix, returns the full report
+static classification_report set_quality(BenchmarkResult& result, const vector<int>& predictions, const vector<int>& labels) {
+    classification_report report = metrics::report(predictions, labels);
+    result.accuracy = report.accuracy;
+    result.precision = report.macro_precision;
+    result.recall = report.macro_recall;
+    result.f1_score = metrics::f1_score(report);
+    return report;
+}
+
+// Helper: Class names for the per-class report (decoded targets, or the codes themselves)
+static vector<string> class_names(const data_frame& df, const DatasetConfig& dataset_config) {
+    vector<string> names;
+    if (dataset_config.needs_encoding) {
+        const string_col* target = df.get_string_column(dataset_config.target_col);
+        for (size_t c = 0; c < target->num_unique_values(); ++c) {
+            names.push_back(target->decode(c));
+        }
+    }
+    return names;
+}
+
+// Helper: Print the phase timings of a single run
+static void print_timings(const BenchmarkResult& result) {
+    cout << "Load time:       " << fixed << setprecision(2) << result.load_time_ms << " ms" << endl;
+    cout << "Training time:   " << result.training_time_ms << " ms ("
+         << setprecision(0) << result.train_throughput << " samples*trees/s)" << endl;
+    cout << "Prediction time: " << setprecision(2) << result.predict_time_ms << " ms ("
+         << setprecision(0) << result.predict_throughput << " rows/s)" << endl;
+    cout.unsetf(ios::fixed);
+    cout << setprecision(6);
+}
+
 BenchmarkResult run_decision_tree_benchmark(const DatasetConfig& dataset_config, bool use_parallel, bool silent) {
     if (!silent) {
         cout << "\n=== Testing Decision Tree ===" << endl;
         cout << "Loading dataset from: " << dataset_config.path << endl;
     }
     
+    auto load_start = chrono::high_resolution_clock::now();
+    
     // Importing dataset
-    data_frame df = data_frame::import_from(dataset_config.path);
+    data_frame df = load_dataset(dataset_config);
 
     // ============================================================
     // DATASET SUBSAMPLING FOR LARGE DATASETS
@@ -128,6 +252,7 @@ BenchmarkResult run_decision_tree_benchmark(const DatasetConfig& dataset_config,
         train_df.get_string_column(dataset_config.target_col)->fit_encoding();
         test_df.get_string_column(dataset_config.target_col)->fit_encoding();
     }
+    double load_time_ms = elapsed_ms(load_start);
 
     if (!silent) {
         cout << "Data loaded and encoded. Fitting tree..." << endl;
@@ -154,20 +279,21 @@ BenchmarkResult run_decision_tree_benchmark(const DatasetConfig& dataset_config,
 
     tree.hp_config = &hp_config;
 
-    auto time_start = chrono::high_resolution_clock::now();
+    profiler::reset();
     
     // Fitting tree to training data
+    auto train_start = chrono::high_resolution_clock::now();
     tree.fit(train_df, dataset_config.feature_cols, dataset_config.target_col);
+    double training_time_ms = elapsed_ms(train_start);
 
     if (!silent) {
         cout << "Predicting..." << endl;
     }
     
     // Get predictions for test set
+    auto predict_start = chrono::high_resolution_clock::now();
     vector<int> predictions = tree.predict(test_df);
-    
-    auto time_end = chrono::high_resolution_clock::now();
-    auto duration = chrono::duration_cast<chrono::milliseconds>(time_end - time_start);
+    double predict_time_ms = elapsed_ms(predict_start);
     
     // Get true labels for test set
     vector<int> encoded_labels;
@@ -184,11 +310,14 @@ BenchmarkResult run_decision_tree_benchmark(const DatasetConfig& dataset_config,
 
     // Calculate metrics
     BenchmarkResult result;
-    result.training_time_ms = duration.count();
-    result.accuracy = metrics::accuracy(predictions, encoded_labels);
-    result.precision = metrics::precision(predictions, encoded_labels);
-    result.recall = metrics::recall(predictions, encoded_labels);
-    result.f1_score = metrics::f1_score(predictions, encoded_labels);
+    result.load_time_ms = load_time_ms;
+    result.training_time_ms = training_time_ms;
+    result.predict_time_ms = predict_time_ms;
+    result.train_samples = train_df.get_num_rows();
+    result.test_samples = test_df.get_num_rows();
+    result.num_trees = 1;
+    set_throughput(result);
+    classification_report report = set_quality(result, predictions, encoded_labels);
     result.speedup = 1.0;  // Will be calculated later
 
     if (!silent) {
@@ -197,7 +326,10 @@ BenchmarkResult run_decision_tree_benchmark(const DatasetConfig& dataset_config,
         cout << "Precision: " << result.precision << endl;
         cout << "Recall:    " << result.recall << endl;
         cout << "F1 score:  " << result.f1_score << endl;
-        cout << "Training & evaluation time taken: " << result.training_time_ms << " milliseconds" << endl;
+        cout << endl;
+        metrics::print_report(report, cout, class_names(test_df, dataset_config));
+        print_timings(result);
+        report_profile();
     }
 
     return result;
@@ -209,8 +341,10 @@ BenchmarkResult run_random_forest_benchmark(const DatasetConfig& dataset_config,
         cout << "Loading dataset from: " << dataset_config.path << endl;
     }
 
+    auto load_start = chrono::high_resolution_clock::now();
+
     // Importing dataset
-    data_frame df = data_frame::import_from(dataset_config.path);
+    data_frame df = load_dataset(dataset_config);
 
     // ============================================================
     // DATASET SUBSAMPLING FOR LARGE DATASETS
@@ -232,6 +366,7 @@ BenchmarkResult run_random_forest_benchmark(const DatasetConfig& dataset_config,
         train_df.get_string_column(dataset_config.target_col)->fit_encoding();
         test_df.get_string_column(dataset_config.target_col)->fit_encoding();
     }
+    double load_time_ms = elapsed_ms(load_start);
 
     if (!silent) {
         cout << "Data loaded. Fitting forest with " << num_trees << " trees..." << endl;
@@ -273,14 +408,15 @@ BenchmarkResult run_random_forest_benchmark(const DatasetConfig& dataset_config,
     }
 
     // Fitting forest to training data
-    auto time_start = chrono::high_resolution_clock::now();
+    profiler::reset();
+    auto train_start = chrono::high_resolution_clock::now();
     forest.fit(train_df, dataset_config.feature_cols, dataset_config.target_col);
+    double training_time_ms = elapsed_ms(train_start);
 
     // Getting predictions for test set
+    auto predict_start = chrono::high_resolution_clock::now();
     vector<int> predictions = forest.predict(test_df);
-    
-    auto time_end = chrono::high_resolution_clock::now();
-    auto duration = chrono::duration_cast<chrono::milliseconds>(time_end - time_start);
+    double predict_time_ms = elapsed_ms(predict_start);
     
     // Getting true labels for test set
     vector<int> encoded_labels;
@@ -295,11 +431,14 @@ BenchmarkResult run_random_forest_benchmark(const DatasetConfig& dataset_config,
 
     // Calculate metrics
     BenchmarkResult result;
-    result.training_time_ms = duration.count();
-    result.accuracy = metrics::accuracy(predictions, encoded_labels);
-    result.precision = metrics::precision(predictions, encoded_labels);
-    result.recall = metrics::recall(predictions, encoded_labels);
-    result.f1_score = metrics::f1_score(predictions, encoded_labels);
+    result.load_time_ms = load_time_ms;
+    result.training_time_ms = training_time_ms;
+    result.predict_time_ms = predict_time_ms;
+    result.train_samples = train_df.get_num_rows();
+    result.test_samples = test_df.get_num_rows();
+    result.num_trees = num_trees;
+    set_throughput(result);
+    classification_report report = set_quality(result, predictions, encoded_labels);
     result.speedup = 1.0;  // Will be calculated later
 
     if (!silent) {
@@ -308,7 +447,10 @@ BenchmarkResult run_random_forest_benchmark(const DatasetConfig& dataset_config,
         cout << "Precision: " << result.precision << endl;
         cout << "Recall:    " << result.recall << endl;
         cout << "F1 score:  " << result.f1_score << endl;
-        cout << "Training & evaluation time taken: " << result.training_time_ms << " milliseconds" << endl;
+        cout << endl;
+        metrics::print_report(report, cout, class_names(test_df, dataset_config));
+        print_timings(result);
+        report_profile();
     }
 
     return result;
@@ -331,7 +473,7 @@ void benchmark_decision_tree(const DatasetConfig& dataset_config) {
     cout << "[2/2] Testing with tree-level parallelism..." << endl;
     BenchmarkResult tree_parallel_result = run_decision_tree_benchmark(dataset_config, true, false);
     tree_parallel_result.config_name = "Tree-level Parallelism";
-    tree_parallel_result.speedup = serial_result.training_time_ms / tree_parallel_result.training_time_ms;
+    set_speedups(tree_parallel_result, serial_result);
     results.push_back(tree_parallel_result);
     
     // Print results table
@@ -357,14 +499,14 @@ void benchmark_random_forest(const DatasetConfig& dataset_config, int num_trees)
     cout << "[2/3] Testing with tree-level parallelism..." << endl;
     BenchmarkResult tree_parallel_result = run_random_forest_benchmark(dataset_config, false, true, num_trees, false);
     tree_parallel_result.config_name = "Tree-level Parallelism";
-    tree_parallel_result.speedup = serial_result.training_time_ms / tree_parallel_result.training_time_ms;
+    set_speedups(tree_parallel_result, serial_result);
     results.push_back(tree_parallel_result);
     
     // Test 3: Forest-level Parallelism Only
     cout << "[3/3] Testing with forest-level parallelism..." << endl;
     BenchmarkResult forest_parallel_result = run_random_forest_benchmark(dataset_config, true, false, num_trees, false);
     forest_parallel_result.config_name = "Forest-level Parallelism";
-    forest_parallel_result.speedup = serial_result.training_time_ms / forest_parallel_result.training_time_ms;
+    set_speedups(forest_parallel_result, serial_result);
     results.push_back(forest_parallel_result);
     
     // Print results table
@@ -374,18 +516,16 @@ void benchmark_random_forest(const DatasetConfig& dataset_config, int num_trees)
 // Helper function to run benchmark with specific sample size
 BenchmarkResult run_benchmark_with_sample_size(const DatasetConfig& dataset_config, int target_samples, int num_trees, bool use_forest_parallel, bool use_tree_parallel) {
     // Load full dataset
-    data_frame df = data_frame::import_from(dataset_config.path);
+    auto load_start = chrono::high_resolution_clock::now();
+    data_frame df = load_dataset(dataset_config);
     
-    // Calculate the split ratio to get approximately target_samples
-    // For Dry Bean: 13611 total samples
-    // We want target_samples, so keep ratio = target_samples / 13611
-    double total_samples = 13611.0;  // Dry Bean dataset size
+    // Subsample to approximately target_samples (the whole data set if it is smaller)
+    double total_samples = df.get_num_rows();
     double keep_ratio = target_samples / total_samples;
-    double discard_ratio = 1.0 - keep_ratio;
-    
-    // Subsample to get target size
-    auto [subset_df, _] = df.train_test_split(discard_ratio);
-    df = std::move(subset_df);
+    if (keep_ratio < 1.0) {
+        auto [subset_df, _] = df.train_test_split(1.0 - keep_ratio);
+        df = std::move(subset_df);
+    }
     
     // Train-test split (80-20)
     auto [train_df, test_df] = df.train_test_split(0.2);
@@ -395,6 +535,7 @@ BenchmarkResult run_benchmark_with_sample_size(const DatasetConfig& dataset_conf
         train_df.get_string_column(dataset_config.target_col)->fit_encoding();
         test_df.get_string_column(dataset_config.target_col)->fit_encoding();
     }
+    double load_time_ms = elapsed_ms(load_start);
     
     // Initialize random forest
     random_forest forest;
@@ -421,12 +562,14 @@ BenchmarkResult run_benchmark_with_sample_size(const DatasetConfig& dataset_conf
     hp_config.min_examples_per_leaf = 20;
     forest.hp_config = &hp_config;
     
-    // Fit and measure time
-    auto time_start = chrono::high_resolution_clock::now();
+    // Fit and predict, timed separately
+    auto train_start = chrono::high_resolution_clock::now();
     forest.fit(train_df, dataset_config.feature_cols, dataset_config.target_col);
+    double training_time_ms = elapsed_ms(train_start);
+    
+    auto predict_start = chrono::high_resolution_clock::now();
     vector<int> predictions = forest.predict(test_df);
-    auto time_end = chrono::high_resolution_clock::now();
-    auto duration = chrono::duration_cast<chrono::milliseconds>(time_end - time_start);
+    double predict_time_ms = elapsed_ms(predict_start);
     
     // Get true labels
     vector<int> encoded_labels;
@@ -441,11 +584,14 @@ BenchmarkResult run_benchmark_with_sample_size(const DatasetConfig& dataset_conf
     
     // Calculate metrics
     BenchmarkResult result;
-    result.training_time_ms = duration.count();
-    result.accuracy = metrics::accuracy(predictions, encoded_labels);
-    result.precision = metrics::precision(predictions, encoded_labels);
-    result.recall = metrics::recall(predictions, encoded_labels);
-    result.f1_score = metrics::f1_score(predictions, encoded_labels);
+    result.load_time_ms = load_time_ms;
+    result.training_time_ms = training_time_ms;
+    result.predict_time_ms = predict_time_ms;
+    result.train_samples = train_df.get_num_rows();
+    result.test_samples = test_df.get_num_rows();
+    result.num_trees = num_trees;
+    set_throughput(result);
+    set_quality(result, predictions, encoded_labels);
     result.speedup = 1.0;
     
     return result;
@@ -475,7 +621,7 @@ void benchmark_sample_sizes(const DatasetConfig& dataset_config, int num_trees)
         cout << "  -> Running forest-parallel version..." << endl;
         BenchmarkResult parallel_result = run_benchmark_with_sample_size(dataset_config, samples, num_trees, true, false);
         parallel_result.config_name = to_string(samples) + " samples (Forest-parallel)";
-        parallel_result.speedup = serial_result.training_time_ms / parallel_result.training_time_ms;
+        set_speedups(parallel_result, serial_result);
         results.push_back(parallel_result);
     }
     
@@ -484,8 +630,8 @@ void benchmark_sample_sizes(const DatasetConfig& dataset_config, int num_trees)
     
     // Additional analysis: Extract serial and parallel times
     cout << "\n=== Sample Size Scaling Analysis ===" << endl;
-    cout << "\nSerial Performance:" << endl;
-    cout << "Sample Size | Time (ms) | Time Ratio" << endl;
+    cout << "\nSerial Performance (training):" << endl;
+    cout << "Sample Size | Train (ms) | Time Ratio" << endl;
     cout << string(45, '-') << endl;
     
     double serial_baseline = results[0].training_time_ms;
@@ -493,21 +639,688 @@ void benchmark_sample_sizes(const DatasetConfig& dataset_config, int num_trees)
         int idx = i * 2;  // Serial results are at even indices
         double time_ratio = results[idx].training_time_ms / serial_baseline;
         cout << setw(11) << sample_sizes[i] << " | " 
-             << setw(9) << fixed << setprecision(2) << results[idx].training_time_ms << " | "
+             << setw(10) << fixed << setprecision(2) << results[idx].training_time_ms << " | "
              << setw(10) << fixed << setprecision(2) << time_ratio << "x" << endl;
     }
     
     cout << "\n\nParallel Performance & Speedup:" << endl;
-    cout << "Sample Size | Time (ms) | Speedup vs Serial" << endl;
-    cout << string(50, '-') << endl;
+    cout << "Sample Size | Train (ms) | Train speedup | Predict (ms) | Predict speedup" << endl;
+    cout << string(75, '-') << endl;
     
     for (size_t i = 0; i < sample_sizes.size(); i++) {
-        int serial_idx = i * 2;
         int parallel_idx = i * 2 + 1;
         cout << setw(11) << sample_sizes[i] << " | " 
-             << setw(9) << fixed << setprecision(2) << results[parallel_idx].training_time_ms << " | "
-             << setw(17) << fixed << setprecision(2) << results[parallel_idx].speedup << "x" << endl;
+             << setw(10) << fixed << setprecision(2) << results[parallel_idx].training_time_ms << " | "
+             << setw(12) << fixed << setprecision(2) << results[parallel_idx].speedup << "x | "
+             << setw(12) << fixed << setprecision(2) << results[parallel_idx].predict_time_ms << " | "
+             << setw(14) << fixed << setprecision(2) << results[parallel_idx].predict_speedup << "x" << endl;
     }
     cout << endl;
 }
 
+
+void benchmark_cross_validation(const DatasetConfig& dataset_config, int num_trees, int num_folds) {
+    cout << "\n=== K-FOLD CROSS-VALIDATION (RANDOM FOREST) ===" << endl;
+    cout << "Loading dataset from: " << dataset_config.path << endl;
+    
+    // Loaded once; every fold is an index view over this data_frame
+    data_frame df = load_dataset(dataset_config);
+    
+    if (dataset_config.path == "dataset/Dry_Bean_Dataset.csv") {
+        auto [subset_df, _] = df.train_test_split(0.75);
+        df = std::move(subset_df);
+        cout << "Using 25% subset for faster training (approx 3,400 samples)" << endl;
+    }
+    
+    random_forest_config rf_config;
+    rf_config.num_trees = num_trees;
+    rf_config.bootstrap_sample_ratio = 0.55;
+    
+    tree_growing_config growing_config;
+    growing_config.criterion = tree_growing_config::SplitCriterion::GINI;
+    
+    tree_hyperparameters hp_config;
+    hp_config.max_depth = 300;
+    hp_config.min_examples_per_leaf = 20;
+    
+    cv_config config;
+    config.num_folds = num_folds;
+    config.use_parallel = true;
+    
+    cross_validator validator;
+    validator.config = &config;
+    validator.hp_config = &hp_config;
+    validator.growing_config = &growing_config;
+    validator.rf_config = &rf_config;
+    
+    cout << "Running " << num_folds << " folds in parallel with " << num_trees << " trees each..." << endl;
+    cv_result cv = validator.run(df, dataset_config.feature_cols, dataset_config.target_col);
+    
+    cout << "\n" << left;
+    cout << setw(8) << "Fold"
+         << setw(12) << "Train rows"
+         << setw(12) << "Test rows"
+         << setw(14) << "Train (ms)"
+         << setw(14) << "Predict (ms)"
+         << setw(12) << "Accuracy"
+         << setw(12) << "F1 score"
+         << endl;
+    cout << string(84, '-') << endl;
+    
+    for (const auto& fold : cv.folds) {
+        cout << setw(8) << fold.fold
+             << setw(12) << fold.train_rows
+             << setw(12) << fold.test_rows
+             << setw(14) << fixed << setprecision(2) << fold.train_time_ms
+             << setw(14) << fixed << setprecision(2) << fold.predict_time_ms
+             << setw(12) << fixed << setprecision(4) << fold.accuracy
+             << setw(12) << fixed << setprecision(4) << fold.f1_score
+             << endl;
+    }
+    
+    cout << string(84, '-') << endl;
+    cout << "Mean accuracy: " << fixed << setprecision(4) << cv.mean_accuracy
+         << " +/- " << cv.stddev_accuracy << endl;
+    cout << "Mean F1 score: " << cv.mean_f1_score << endl;
+    cout << "Wall time:     " << setprecision(2) << cv.wall_time_ms << " ms" << endl;
+}
+
+void benchmark_grid_search(const DatasetConfig& dataset_config, int max_trees) {
+    cout << "\n=== PARALLEL GRID SEARCH (RANDOM FOREST) ===" << endl;
+    cout << "Loading dataset from: " << dataset_config.path << endl;
+    
+    data_frame df = load_dataset(dataset_config);
+    
+    // Same 25% subset as the other benchmarks for the large dataset
+    if (dataset_config.path == "dataset/Dry_Bean_Dataset.csv") {
+        auto [subset_df, _] = df.train_test_split(0.75);
+        df = std::move(subset_df);
+        cout << "Using 25% subset for faster training (approx 3,400 samples)" << endl;
+    }
+    
+    search_space space;
+    space.max_depth = {5, 10, -1};
+    space.min_examples_per_leaf = {5, 20};
+    space.criterion = {
+        tree_growing_config::SplitCriterion::GINI,
+        tree_growing_config::SplitCriterion::SHANNON_ENTROPY
+    };
+    space.num_trees = {max_trees};
+    space.bootstrap_sample_ratio = {0.55, 1.0};
+    
+    grid_search_config config;
+    config.num_folds = 3;
+    config.use_successive_halving = true;
+    config.halving_factor = 3;
+    config.min_trees = max(1, max_trees / 9);
+    
+    grid_search search;
+    search.search_config = &config;
+    search.on_result = [](const search_result& result) {
+        cout << "  [rung " << result.rung << ", " << setw(3) << result.trees_trained << " trees] "
+             << fixed << setprecision(4) << result.mean_accuracy
+             << " +/- " << result.stddev_accuracy
+             << "  (" << setprecision(0) << result.train_time_ms << " ms)  "
+             << result.candidate.describe() << endl;
+    };
+    
+    cout << "Searching " << grid_search::enumerate(space).size() << " candidates with "
+         << config.num_folds << "-fold cross-validation on " << omp_get_max_threads() << " threads...\n" << endl;
+    
+    auto time_start = chrono::high_resolution_clock::now();
+    vector<search_result> results = search.run(df, dataset_config.feature_cols, dataset_config.target_col, space);
+    auto time_end = chrono::high_resolution_clock::now();
+    
+    cout << "\n=== Best Configurations ===" << endl;
+    for (size_t i = 0; i < min<size_t>(5, results.size()); ++i) {
+        const auto& result = results[i];
+        cout << (i + 1) << ". " << fixed << setprecision(4) << result.mean_accuracy
+             << " +/- " << result.stddev_accuracy
+             << (result.eliminated ? "  (eliminated) " : "  ")
+             << result.candidate.describe() << endl;
+    }
+    cout << "Total search time: " << fixed << setprecision(2)
+         << chrono::duration<double, milli>(time_end - time_start).count() << " ms" << endl;
+}
+
+// ==================== Repeated-run harness ====================
+
+// Train/test split shared by every run of a repeated benchmark
+struct harness_data {
+    data_frame train_df;
+    data_frame test_df;
+    vector<int> test_labels;
+};
+
+// Helper: Load, subsample, split and encode once (same split as the single-run benchmarks)
+static harness_data load_harness_data(const DatasetConfig& dataset_config) {
+    data_frame df = load_dataset(dataset_config);
+    if (dataset_config.path == "dataset/Dry_Bean_Dataset.csv") {
+        auto [subset_df, _] = df.train_test_split(0.75);
+        df = std::move(subset_df);
+    }
+    
+    auto [train_df, test_df] = df.train_test_split(0.2);
+    if (dataset_config.needs_encoding) {
+        train_df.get_string_column(dataset_config.target_col)->fit_encoding();
+        test_df.get_string_column(dataset_config.target_col)->fit_encoding();
+    }
+    
+    harness_data data{std::move(train_df), std::move(test_df), {}};
+    if (dataset_config.needs_encoding) {
+        const string_col* labels = data.test_df.get_string_column(dataset_config.target_col);
+        for (const string& label : labels->get_data()) {
+            data.test_labels.push_back(labels->encode(label));
+        }
+    } else {
+        data.test_labels = data.test_df.get_int_column(dataset_config.target_col)->get_data();
+    }
+    return data;
+}
+
+#ifdef __linux__
+// Helper: CPUs the process was allowed to run on, captured before the first pinning
+// narrows the main thread's own mask (nullptr if unavailable)
+static const cpu_set_t* allowed_cpus() {
+    static cpu_set_t allowed;
+    static bool have_allowed = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+    return have_allowed ? &allowed : nullptr;
+}
+#endif
+
+// Helper: Pin OpenMP thread i to the i-th CPU the process was allowed to run on.
+// Only the threads of a num_threads team are pinned; nested teams stay unpinned.
+static bool pin_openmp_threads(int num_threads) {
+#ifdef __linux__
+    const cpu_set_t* allowed = allowed_cpus();
+    if (!allowed) return false;
+    
+    vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, allowed)) cpus.push_back(cpu);
+    }
+    if (cpus.empty()) return false;
+    
+    int failures = 0;
+    #pragma omp parallel num_threads(num_threads) reduction(+:failures)
+    {
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        CPU_SET(cpus[omp_get_thread_num() % cpus.size()], &mask);
+        failures += sched_setaffinity(0, sizeof(mask), &mask) != 0;
+    }
+    return failures == 0;
+#else
+    (void)num_threads;
+    return false;
+#endif
+}
+
+// Helper: Give the threads pinned by pin_openmp_threads(num_threads), the main thread
+// included, the process's original CPU mask back
+static void unpin_openmp_threads(int num_threads) {
+#ifdef __linux__
+    const cpu_set_t* allowed = allowed_cpus();
+    if (!allowed) return;
+    
+    #pragma omp parallel num_threads(num_threads)
+    {
+        sched_setaffinity(0, sizeof(*allowed), allowed);
+    }
+#else
+    (void)num_threads;
+#endif
+}
+
+// Helper: One fit + predict on the shared split, returns accuracy
+static double timed_run(const harness_data& data, const DatasetConfig& dataset_config, int num_trees,
+                        bool use_forest_parallel, bool use_tree_parallel, const HarnessConfig& harness,
+                        double& train_ms, double& predict_ms) {
+    tree_growing_config growing_config;
+    if (harness.growing_config) {
+        growing_config = *harness.growing_config;
+    } else {
+        growing_config.criterion = tree_growing_config::SplitCriterion::GINI;
+        growing_config.max_features_per_split = -1;
+        growing_config.min_samples_for_parallel = 100;
+        growing_config.max_parallel_depth = 8;
+    }
+    growing_config.use_parallel = use_tree_parallel;
+    
+    vector<int> predictions;
+    if (num_trees == 0) {
+        tree_hyperparameters hp_config;
+        hp_config.max_depth = 100;
+        hp_config.min_examples_per_leaf = 5;
+        if (harness.hp_config) hp_config = *harness.hp_config;
+        
+        decision_tree tree;
+        tree.growing_config = &growing_config;
+        tree.hp_config = &hp_config;
+        
+        auto train_start = chrono::high_resolution_clock::now();
+        tree.fit(data.train_df, dataset_config.feature_cols, dataset_config.target_col);
+        train_ms = elapsed_ms(train_start);
+        
+        auto predict_start = chrono::high_resolution_clock::now();
+        predictions = tree.predict(data.test_df);
+        predict_ms = elapsed_ms(predict_start);
+    } else {
+        random_forest_config config;
+        config.bootstrap_sample_ratio = 0.55;
+        if (harness.rf_config) config = *harness.rf_config;
+        config.num_trees = num_trees;
+        config.use_parallel = use_forest_parallel;
+        
+        tree_hyperparameters hp_config;
+        hp_config.max_depth = 300;
+        hp_config.min_examples_per_leaf = 20;
+        if (harness.hp_config) hp_config = *harness.hp_config;
+        
+        random_forest forest;
+        forest.rf_config = &config;
+        forest.growing_config = &growing_config;
+        forest.hp_config = &hp_config;
+        
+        auto train_start = chrono::high_resolution_clock::now();
+        forest.fit(data.train_df, dataset_config.feature_cols, dataset_config.target_col);
+        train_ms = elapsed_ms(train_start);
+        
+        auto predict_start = chrono::high_resolution_clock::now();
+        predictions = forest.predict(data.test_df);
+        predict_ms = elapsed_ms(predict_start);
+    }
+    
+    return metrics::accuracy(predictions, data.test_labels);
+}
+
+// Helper: Warmup plus timed repetitions of one configuration at a fixed thread count
+static HarnessResult run_repetitions(const harness_data& data, const DatasetConfig& dataset_config, int num_trees,
+                                     bool use_forest_parallel, bool use_tree_parallel, int num_threads, const HarnessConfig& harness) {
+    HarnessResult result;
+    result.num_threads = num_threads;
+    result.num_trees = max(num_trees, 1);
+    result.train_samples = data.train_df.get_num_rows();
+    result.test_samples = data.test_df.get_num_rows();
+    
+    omp_set_num_threads(num_threads);
+    result.pinned = harness.pin_threads && pin_openmp_threads(num_threads);
+    
+    double accuracy_sum = 0.0;
+    for (int rep = 0; rep < harness.warmup_runs + harness.repetitions; ++rep) {
+        double train_ms = 0.0;
+        double predict_ms = 0.0;
+        double accuracy = timed_run(data, dataset_config, num_trees, use_forest_parallel, use_tree_parallel, harness, train_ms, predict_ms);
+        if (rep < harness.warmup_runs) continue;
+        
+        result.train_times_ms.push_back(train_ms);
+        result.predict_times_ms.push_back(predict_ms);
+        accuracy_sum += accuracy;
+    }
+    if (harness.pin_threads) unpin_openmp_threads(num_threads);
+    
+    result.train_stats = summarize_timings(result.train_times_ms);
+    result.predict_stats = summarize_timings(result.predict_times_ms);
+    result.mean_accuracy = harness.repetitions > 0 ? accuracy_sum / harness.repetitions : 0.0;
+    return result;
+}
+
+// Two-sided 95% Student's t critical values for 1..30 degrees of freedom
+static double t_critical_95(int degrees_of_freedom) {
+    static const double table[30] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (degrees_of_freedom < 1) return 0.0;
+    return degrees_of_freedom <= 30 ? table[degrees_of_freedom - 1] : 1.960;
+}
+
+TimingStats summarize_timings(const vector<double>& samples_ms) {
+    TimingStats stats;
+    stats.samples = samples_ms.size();
+    if (samples_ms.empty()) return stats;
+    
+    vector<double> sorted = samples_ms;
+    sort(sorted.begin(), sorted.end());
+    size_t n = sorted.size();
+    stats.min = sorted.front();
+    stats.max = sorted.back();
+    stats.median = n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2.0;
+    
+    double sum = 0.0;
+    for (double sample : sorted) sum += sample;
+    stats.mean = sum / n;
+    
+    double squared = 0.0;
+    for (double sample : sorted) squared += (sample - stats.mean) * (sample - stats.mean);
+    stats.stddev = n > 1 ? sqrt(squared / (n - 1)) : 0.0;
+    
+    double half_width = t_critical_95(n - 1) * stats.stddev / sqrt((double)n);
+    stats.ci95_low = stats.mean - half_width;
+    stats.ci95_high = stats.mean + half_width;
+    return stats;
+}
+
+vector<HarnessResult> benchmark_repeated(const DatasetConfig& dataset_config, int num_trees, const HarnessConfig& harness) {
+    int default_threads = omp_get_max_threads();
+    int num_threads = harness.num_threads > 0 ? harness.num_threads : default_threads;
+    
+    cout << "\n=== REPEATED BENCHMARK (" << (num_trees == 0 ? "DECISION TREE" : "RANDOM FOREST") << ") ===" << endl;
+    cout << "Loading dataset once from: " << dataset_config.path << endl;
+    harness_data data = load_harness_data(dataset_config);
+    cout << harness.warmup_runs << " warmup + " << harness.repetitions << " timed runs per configuration, "
+         << num_threads << " threads" << (harness.pin_threads ? " (pinned)" : "") << endl;
+    
+    struct run_config { string name; bool forest_parallel; bool tree_parallel; };
+    vector<run_config> configs = {{"Serial (No Parallelism)", false, false}, {"Tree-level Parallelism", false, true}};
+    if (num_trees > 0) {
+        configs.push_back({"Forest-level Parallelism", true, false});
+    }
+    
+    vector<HarnessResult> results;
+    for (size_t i = 0; i < configs.size(); ++i) {
+        const run_config& run = configs[i];
+        cout << "[" << (i + 1) << "/" << configs.size() << "] " << run.name << "..." << flush;
+        
+        HarnessResult result = run_repetitions(data, dataset_config, num_trees, run.forest_parallel, run.tree_parallel, num_threads, harness);
+        result.config_name = run.name;
+        results.push_back(result);
+        cout << " done" << endl;
+    }
+    
+    omp_set_num_threads(default_threads);
+    print_harness_table(results);
+    if (!harness.json_path.empty()) {
+        write_harness_json(harness.json_path, dataset_config, harness, results);
+        cout << "JSON results written to " << harness.json_path << endl;
+    }
+    if (!harness.csv_path.empty()) {
+        write_harness_csv(harness.csv_path, dataset_config, results);
+        cout << "CSV results written to " << harness.csv_path << endl;
+    }
+    return results;
+}
+
+void print_harness_table(const vector<HarnessResult>& results) {
+    cout << "\n" << left;
+    cout << setw(28) << "Configuration"
+         << setw(8) << "Phase"
+         << setw(12) << "Median (ms)"
+         << setw(12) << "Min (ms)"
+         << setw(12) << "Stddev"
+         << setw(24) << "95% CI of mean (ms)"
+         << setw(10) << "Speedup"
+         << setw(10) << "Accuracy"
+         << endl;
+    cout << string(116, '-') << endl;
+    
+    for (const auto& result : results) {
+        for (int phase = 0; phase < 2; ++phase) {
+            const TimingStats& stats = phase == 0 ? result.train_stats : result.predict_stats;
+            const TimingStats& baseline = phase == 0 ? results[0].train_stats : results[0].predict_stats;
+            double speedup = stats.median > 0 ? baseline.median / stats.median : 0.0;
+            
+            cout << setw(28) << (phase == 0 ? result.config_name : "")
+                 << setw(8) << (phase == 0 ? "train" : "predict")
+                 << setw(12) << fixed << setprecision(3) << stats.median
+                 << setw(12) << stats.min
+                 << setw(12) << stats.stddev
+                 << setw(24) << ("[" + to_string_fixed(stats.ci95_low, 3) + ", " + to_string_fixed(stats.ci95_high, 3) + "]")
+                 << setw(10) << (to_string_fixed(speedup, 2) + "x");
+            if (phase == 0) {
+                cout << setw(10) << setprecision(4) << result.mean_accuracy;
+            }
+            cout << endl;
+        }
+    }
+    
+    cout << string(116, '-') << endl;
+    cout << "(speedup = baseline median / median; " << (results.empty() ? 0 : results[0].train_stats.samples)
+         << " timed runs per configuration)" << endl;
+    cout.unsetf(ios::fixed);
+    cout << setprecision(6);
+}
+
+// Helper: JSON string literal (config names and paths only, no control characters)
+static string json_quote(const string& text) {
+    string quoted = "\"";
+    for (char ch : text) {
+        if (ch == '"' || ch == '\\') quoted += '\\';
+        quoted += ch;
+    }
+    return quoted + "\"";
+}
+
+// Helper: JSON object of a TimingStats plus its raw samples
+static void write_stats_json(ostream& out, const TimingStats& stats, const vector<double>& samples) {
+    out << "{\"median\": " << stats.median << ", \"min\": " << stats.min << ", \"max\": " << stats.max
+        << ", \"mean\": " << stats.mean << ", \"stddev\": " << stats.stddev
+        << ", \"ci95\": [" << stats.ci95_low << ", " << stats.ci95_high << "], \"samples_ms\": [";
+    for (size_t i = 0; i < samples.size(); ++i) {
+        out << (i ? ", " : "") << samples[i];
+    }
+    out << "]}";
+}
+
+void write_harness_json(const string& path, const DatasetConfig& dataset_config, const HarnessConfig& harness, const vector<HarnessResult>& results) {
+    ofstream out(path);
+    if (!out.is_open()) {
+        throw runtime_error("Could not open file for writing: " + path);
+    }
+    
+    out << fixed << setprecision(4);
+    out << "{\n";
+    out << "  \"dataset\": " << json_quote(dataset_config.path) << ",\n";
+    out << "  \"warmup_runs\": " << harness.warmup_runs << ",\n";
+    out << "  \"repetitions\": " << harness.repetitions << ",\n";
+    out << "  \"num_procs\": " << omp_get_num_procs() << ",\n";
+#ifdef __VERSION__
+    out << "  \"compiler\": " << json_quote(__VERSION__) << ",\n";
+#endif
+    out << "  \"profiled_build\": " << (profiler::is_enabled() ? "true" : "false") << ",\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& result = results[i];
+        out << "    {\"config\": " << json_quote(result.config_name)
+            << ", \"num_threads\": " << result.num_threads
+            << ", \"pinned\": " << (result.pinned ? "true" : "false")
+            << ", \"num_trees\": " << result.num_trees
+            << ", \"train_samples\": " << result.train_samples
+            << ", \"test_samples\": " << result.test_samples
+            << ", \"mean_accuracy\": " << result.mean_accuracy
+            << ",\n     \"train\": ";
+        write_stats_json(out, result.train_stats, result.train_times_ms);
+        out << ",\n     \"predict\": ";
+        write_stats_json(out, result.predict_stats, result.predict_times_ms);
+        out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    
+    if (!out) {
+        throw runtime_error("Failed writing benchmark results: " + path);
+    }
+}
+
+void write_harness_csv(const string& path, const DatasetConfig& dataset_config, const vector<HarnessResult>& results) {
+    ofstream out(path);
+    if (!out.is_open()) {
+        throw runtime_error("Could not open file for writing: " + path);
+    }
+    
+    out << "dataset,config,phase,num_threads,pinned,num_trees,samples,median_ms,min_ms,max_ms,mean_ms,stddev_ms,ci95_low_ms,ci95_high_ms,mean_accuracy\n";
+    out << fixed << setprecision(4);
+    for (const auto& result : results) {
+        for (int phase = 0; phase < 2; ++phase) {
+            const TimingStats& stats = phase == 0 ? result.train_stats : result.predict_stats;
+            out << dataset_config.path << "," << result.config_name << "," << (phase == 0 ? "train" : "predict") << ","
+                << result.num_threads << "," << result.pinned << "," << result.num_trees << "," << stats.samples << ","
+                << stats.median << "," << stats.min << "," << stats.max << "," << stats.mean << ","
+                << stats.stddev << "," << stats.ci95_low << "," << stats.ci95_high << "," << result.mean_accuracy << "\n";
+        }
+    }
+    
+    if (!out) {
+        throw runtime_error("Failed writing benchmark results: " + path);
+    }
+}
+
+// ==================== Thread scaling ====================
+
+// Helper: Same split with the training set redrawn (with replacement, fixed seed) to rows rows
+static harness_data resample_training_set(const harness_data& data, const DatasetConfig& dataset_config, size_t rows) {
+    mt19937 rng(42);
+    uniform_int_distribution<size_t> pick(0, data.train_df.get_num_rows() - 1);
+    vector<size_t> train_indices(rows);
+    for (size_t& idx : train_indices) idx = pick(rng);
+    
+    vector<size_t> test_indices(data.test_df.get_num_rows());
+    for (size_t i = 0; i < test_indices.size(); ++i) test_indices[i] = i;
+    
+    harness_data grown{data.train_df.get_rows(train_indices), data.test_df.get_rows(test_indices), data.test_labels};
+    if (dataset_config.needs_encoding) {
+        grown.train_df.get_string_column(dataset_config.target_col)->fit_encoding();
+        grown.test_df.get_string_column(dataset_config.target_col)->fit_encoding();
+    }
+    return grown;
+}
+
+// Helper: 1, 2, 4, ... below max_threads, then max_threads
+static vector<int> thread_counts(int max_threads) {
+    vector<int> counts;
+    for (int p = 1; p < max_threads; p *= 2) counts.push_back(p);
+    counts.push_back(max_threads);
+    return counts;
+}
+
+vector<ScalingResult> benchmark_scaling(const DatasetConfig& dataset_config, int num_trees, const HarnessConfig& harness) {
+    int default_threads = omp_get_max_threads();
+    int max_threads = harness.num_threads > 0 ? harness.num_threads : omp_get_num_procs();
+    vector<int> counts = thread_counts(max_threads);
+    
+    cout << "\n=== THREAD SCALING (RANDOM FOREST, " << num_trees << " trees) ===" << endl;
+    cout << "Loading dataset once from: " << dataset_config.path << endl;
+    harness_data data = load_harness_data(dataset_config);
+    size_t base_rows = data.train_df.get_num_rows();
+    cout << "Threads:";
+    for (int p : counts) cout << " " << p;
+    cout << " (" << omp_get_num_procs() << " logical CPUs); " << harness.warmup_runs << " warmup + "
+         << harness.repetitions << " timed runs per point" << endl;
+    if (harness.pin_threads) {
+        cout << "Each point pins its outer OpenMP team; nested (forest + tree) teams run unpinned" << endl;
+    }
+    cout << "Weak scaling trains on " << base_rows << " x threads rows (resampled)\n" << endl;
+    
+    struct run_config { string name; bool forest_parallel; bool tree_parallel; };
+    vector<run_config> configs = {
+        {"Forest-level", true, false},
+        {"Tree-level", false, true},
+        {"Forest + tree", true, true}
+    };
+    
+    vector<ScalingResult> results;
+    for (const string mode : {"strong", "weak"}) {
+        for (const run_config& run : configs) {
+            double t1 = 0.0;
+            for (int p : counts) {
+                cout << "  " << mode << " / " << run.name << " / " << p << " threads..." << flush;
+                
+                HarnessResult timed;
+                if (mode == "weak" && p > 1) {
+                    harness_data grown = resample_training_set(data, dataset_config, base_rows * p);
+                    timed = run_repetitions(grown, dataset_config, num_trees, run.forest_parallel, run.tree_parallel, p, harness);
+                } else {
+                    timed = run_repetitions(data, dataset_config, num_trees, run.forest_parallel, run.tree_parallel, p, harness);
+                }
+                
+                ScalingResult point;
+                point.config_name = run.name;
+                point.mode = mode;
+                point.num_threads = p;
+                point.train_samples = timed.train_samples;
+                point.median_train_ms = timed.train_stats.median;
+                point.stddev_train_ms = timed.train_stats.stddev;
+                if (p == 1) t1 = point.median_train_ms;
+                
+                if (point.median_train_ms > 0) {
+                    point.speedup = (mode == "weak" ? p : 1) * t1 / point.median_train_ms;
+                }
+                point.efficiency = point.speedup / p;
+                if (p > 1 && mode == "strong") {
+                    point.serial_fraction = (1.0 / point.speedup - 1.0 / p) / (1.0 - 1.0 / p);
+                } else if (p > 1) {
+                    point.serial_fraction = (p - point.speedup) / (p - 1);
+                }
+                
+                results.push_back(point);
+                cout << " " << fixed << setprecision(2) << point.median_train_ms << " ms" << endl;
+                cout.unsetf(ios::fixed);
+            }
+        }
+    }
+    
+    omp_set_num_threads(default_threads);
+    print_scaling_table(results);
+    if (!harness.csv_path.empty()) {
+        write_scaling_csv(harness.csv_path, dataset_config, results);
+        cout << "CSV results written to " << harness.csv_path << endl;
+    }
+    return results;
+}
+
+void print_scaling_table(const vector<ScalingResult>& results) {
+    cout << "\n" << left;
+    cout << setw(8) << "Mode"
+         << setw(16) << "Configuration"
+         << setw(9) << "Threads"
+         << setw(12) << "Rows"
+         << setw(14) << "Median (ms)"
+         << setw(12) << "Stddev"
+         << setw(10) << "Speedup"
+         << setw(12) << "Efficiency"
+         << setw(14) << "Serial frac."
+         << endl;
+    cout << string(107, '-') << endl;
+    
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& point = results[i];
+        if (i > 0 && point.num_threads == 1) cout << endl;
+        cout << setw(8) << point.mode
+             << setw(16) << point.config_name
+             << setw(9) << point.num_threads
+             << setw(12) << point.train_samples
+             << setw(14) << fixed << setprecision(2) << point.median_train_ms
+             << setw(12) << point.stddev_train_ms
+             << setw(10) << (to_string_fixed(point.speedup, 2) + "x")
+             << setw(12) << setprecision(3) << point.efficiency
+             << setw(14) << (point.num_threads > 1 ? to_string_fixed(point.serial_fraction, 3) : "-")
+             << endl;
+    }
+    
+    cout << string(107, '-') << endl;
+    cout << "Strong: fixed data, serial fraction by Karp-Flatt. Weak: rows = base x threads, speedup is p * T1 / Tp"
+         << " and serial fraction (p - S) / (p - 1)." << endl;
+    cout << "A serial fraction that rises with the thread count points at overhead (SMT siblings, slower cores)"
+         << " rather than serial code." << endl;
+    cout.unsetf(ios::fixed);
+    cout << setprecision(6);
+}
+
+void write_scaling_csv(const string& path, const DatasetConfig& dataset_config, const vector<ScalingResult>& results) {
+    ofstream out(path);
+    if (!out.is_open()) {
+        throw runtime_error("Could not open file for writing: " + path);
+    }
+    
+    out << "dataset,mode,config,num_threads,train_samples,median_train_ms,stddev_train_ms,speedup,efficiency,serial_fraction\n";
+    out << fixed << setprecision(4);
+    for (const auto& point : results) {
+        out << dataset_config.path << "," << point.mode << "," << point.config_name << "," << point.num_threads << ","
+            << point.train_samples << "," << point.median_train_ms << "," << point.stddev_train_ms << ","
+            << point.speedup << "," << point.efficiency << "," << point.serial_fraction << "\n";
+    }
+    
+    if (!out) {
+        throw runtime_error("Failed writing scaling results: " + path);
+    }
+}
@@ -0,0 +1,207 @@
+/*
+Command-line flags and config files for the non-interactive commands
+*/
+
+#include "cli_options.hpp"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+// Helper: Strip leading and trailing whitespace
+static string trim(const string& text) {
+    size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == string::npos) return "";
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(begin, end - begin + 1);
+}
+
+void cli_options::set_value(const string& key, const string& value) {
+    string normalized = trim(key);
+    replace(normalized.begin(), normalized.end(), '-', '_');
+    if (normalized.empty()) {
+        throw invalid_argument("Empty option name");
+    }
+    values[normalized] = trim(value);
+}
+
+cli_options cli_options::parse(int argc, char** argv, int first) {
+    cli_options options;
+    for (int i = first; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.rfind("--", 0) != 0) {
+            throw invalid_argument("Expected --key=value, got: " + arg);
+        }
+        arg = arg.substr(2);
+
+        string key = arg;
+        string value;
+        size_t eq = arg.find('=');
+        if (eq != string::npos) {
+            key = arg.substr(0, eq);
+            value = arg.substr(eq + 1);
+        } else if (i + 1 < argc && string(argv[i + 1]).rfind("--", 0) != 0) {
+            value = argv[++i];
+        } else {
+            value = "true";  // Bare flag
+        }
+
+        if (key == "config") {
+            options.load_file(value);
+        } else {
+            options.set_value(key, value);
+        }
+    }
+    return options;
+}
+
+void cli_options::load_file(const string& path) {
+    ifstream in(path);
+    if (!in.is_open()) {
+        throw invalid_argument("Could not open config file: " + path);
+    }
+
+    string line;
+    int line_number = 0;
+    while (getline(in, line)) {
+        ++line_number;
+        size_t comment = line.find('#');
+        if (comment != string::npos) line.erase(comment);
+        if (trim(line).empty()) continue;
+
+        size_t eq = line.find('=');
+        if (eq == string::npos) {
+            throw invalid_argument(path + ":" + to_string(line_number) + ": expected key = value");
+        }
+        set_value(line.substr(0, eq), line.substr(eq + 1));
+    }
+}
+
+bool cli_options::has(const string& key) const {
+    used.insert(key);
+    return values.count(key) > 0;
+}
+
+string cli_options::get_string(const string& key, const string& default_value) const {
+    used.insert(key);
+    auto it = values.find(key);
+    return it == values.end() ? default_value : it->second;
+}
+
+int cli_options::get_int(const string& key, int default_value) const {
+    if (!has(key)) return default_value;
+    const string& text = values.at(key);
+    size_t parsed = 0;
+    int value = 0;
+    try {
+        value = stoi(text, &parsed);
+    } catch (const exception&) {
+        parsed = 0;
+    }
+    if (parsed == 0 || parsed != text.size()) {
+        throw invalid_argument("Option " + key + " expects an integer, got: " + text);
+    }
+    return value;
+}
+
+size_t cli_options::get_size(const string& key, size_t default_value) const {
+    if (!has(key)) return default_value;
+    const string& text = values.at(key);
+    size_t parsed = 0;
+    unsigned long long value = 0;
+    try {
+        value = text.empty() || text[0] == '-' ? 0 : stoull(text, &parsed);
+    } catch (const exception&) {
+        parsed = 0;
+    }
+    if (parsed == 0 || parsed != text.size()) {
+        throw invalid_argument("Option " + key + " expects a non-negative integer, got: " + text);
+    }
+    return value;
+}
+
+double cli_options::get_double(const string& key, double default_value) const {
+    if (!has(key)) return default_value;
+    const string& text = values.at(key);
+    size_t parsed = 0;
+    double value = 0.0;
+    try {
+        value = stod(text, &parsed);
+    } catch (const exception&) {
+        parsed = 0;
+    }
+    if (parsed == 0 || parsed != text.size()) {
+        throw invalid_argument("Option " + key + " expects a number, got: " + text);
+    }
+    return value;
+}
+
+bool cli_options::get_bool(const string& key, bool default_value) const {
+    if (!has(key)) return default_value;
+    string text = values.at(key);
+    transform(text.begin(), text.end(), text.begin(), [](unsigned char ch) { return tolower(ch); });
+    if (text == "true" || text == "yes" || text == "on" || text == "1") return true;
+    if (text == "false" || text == "no" || text == "off" || text == "0") return false;
+    throw invalid_argument("Option " + key + " expects true or false, got: " + values.at(key));
+}
+
+vector<string> cli_options::get_list(const string& key) const {
+    vector<string> items;
+    if (!has(key)) return items;
+
+    stringstream text(values.at(key));
+    string item;
+    while (getline(text, item, ',')) {
+        item = trim(item);
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+vector<int> cli_options::get_int_list(const string& key, const vector<int>& default_value) const {
+    if (!has(key)) return default_value;
+    vector<int> items;
+    for (const string& item : get_list(key)) {
+        size_t parsed = 0;
+        try {
+            items.push_back(stoi(item, &parsed));
+        } catch (const exception&) {
+            parsed = 0;
+        }
+        if (parsed == 0 || parsed != item.size()) {
+            throw invalid_argument("Option " + key + " expects a list of integers, got: " + values.at(key));
+        }
+    }
+    return items;
+}
+
+vector<double> cli_options::get_double_list(const string& key, const vector<double>& default_value) const {
+    if (!has(key)) return default_value;
+    vector<double> items;
+    for (const string& item : get_list(key)) {
+        size_t parsed = 0;
+        try {
+            items.push_back(stod(item, &parsed));
+        } catch (const exception&) {
+            parsed = 0;
+        }
+        if (parsed == 0 || parsed != item.size()) {
+            throw invalid_argument("Option " + key + " expects a list of numbers, got: " + values.at(key));
+        }
+    }
+    return items;
+}
+
+void cli_options::check_all_used() const {
+    string unknown;
+    for (const auto& [key, value] : values) {
+        if (used.count(key) == 0) {
+            unknown += (unknown.empty() ? "" : ", ") + key;
+        }
+    }
+    if (!unknown.empty()) {
+        throw invalid_argument("Unknown option(s): " + unknown);
+    }
+}
@@ -0,0 +1,360 @@
+/*
+Memory-mapped columnar storage for out-of-core training
+*/
+
+#include "columnar.hpp"
+#include "binary_io.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const char COLUMNAR_MAGIC[8] = {'P', 'R', 'F', 'C', 'O', 'L', '1', '\0'};
+static const int32_t MISSING_INT = numeric_limits<int32_t>::min();
+
+// Helper: Column type <-> on-disk tag
+static uint8_t type_tag(const string& type) {
+    if (type == "int") return 0;
+    if (type == "float") return 1;
+    return 2;
+}
+
+static string tag_type(uint8_t tag) {
+    if (tag == 0) return "int";
+    if (tag == 1) return "float";
+    if (tag == 2) return "string";
+    throw runtime_error("Corrupt columnar file: unknown column type " + to_string(tag));
+}
+
+static size_t type_width(const string& type) {
+    return type == "float" ? sizeof(double) : sizeof(int32_t);
+}
+
+// Helper: Widen a column type so it accepts both inputs (int < float < string)
+static string merge_types(const string& a, const string& b) {
+    if (a == "string" || b == "string") return "string";
+    if (a == "float" || b == "float") return "float";
+    return "int";
+}
+
+// Helper: Read a value from the mapping and advance the cursor
+template <typename T>
+static T read_pod(const char*& cursor) {
+    T value;
+    memcpy(&value, cursor, sizeof(T));
+    cursor += sizeof(T);
+    return value;
+}
+
+// ==================== Conversion ====================
+
+void columnar_file::convert_csv(const string& csv_path, const string& out_path, size_t chunk_rows) {
+    vector<vector<string>> chunk;
+
+    // Pass 1: infer column types and count rows
+    vector<string> headers;
+    vector<string> types;
+    size_t total_rows = 0;
+    {
+        csv_chunk_reader reader(csv_path);
+        headers = reader.get_headers();
+        types.assign(headers.size(), "");
+
+        while (reader.read_chunk(chunk, chunk_rows) > 0) {
+            for (size_t c = 0; c < headers.size(); ++c) {
+                vector<string> values;
+                values.reserve(chunk.size());
+                for (const auto& row : chunk) values.push_back(row[c]);
+
+                string chunk_type = infer_column_type(values);
+                types[c] = types[c].empty() ? chunk_type : merge_types(types[c], chunk_type);
+            }
+            total_rows += chunk.size();
+        }
+    }
+    for (auto& type : types) {
+        if (type.empty()) type = "string";
+    }
+
+    // Header size is fixed once names are known; data sections follow, 8-byte aligned
+    size_t header_size = sizeof(COLUMNAR_MAGIC) + sizeof(uint64_t) + sizeof(uint32_t);
+    for (const auto& name : headers) {
+        header_size += sizeof(uint32_t) + name.size() + sizeof(uint8_t) + 3 * sizeof(uint64_t);
+    }
+
+    vector<uint64_t> data_offsets(headers.size());
+    uint64_t offset = (header_size + 7) & ~uint64_t(7);
+    for (size_t c = 0; c < headers.size(); ++c) {
+        data_offsets[c] = offset;
+        offset += (total_rows * type_width(types[c]) + 7) & ~uint64_t(7);
+    }
+    uint64_t dictionary_start = offset;
+
+    ofstream out(out_path, ios::binary | ios::trunc);
+    if (!out.is_open()) {
+        throw runtime_error("Could not open file for writing: " + out_path);
+    }
+
+    // Pass 2: stream rows into their column sections
+    vector<unordered_map<string, int32_t>> codes(headers.size());
+    vector<vector<string>> dictionaries(headers.size());
+    {
+        csv_chunk_reader reader(csv_path);
+        size_t row_start = 0;
+
+        while (reader.read_chunk(chunk, chunk_rows) > 0) {
+            for (size_t c = 0; c < headers.size(); ++c) {
+                out.seekp(data_offsets[c] + row_start * type_width(types[c]));
+
+                if (types[c] == "int") {
+                    vector<int32_t> values;
+                    values.reserve(chunk.size());
+                    for (const auto& row : chunk) values.push_back(is_missing_value(row[c]) ? MISSING_INT : stoi(row[c]));
+                    out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(int32_t));
+                } else if (types[c] == "float") {
+                    vector<double> values;
+                    values.reserve(chunk.size());
+                    for (const auto& row : chunk) {
+                        values.push_back(is_missing_value(row[c]) ? numeric_limits<double>::quiet_NaN() : stod(row[c]));
+                    }
+                    out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(double));
+                } else {
+                    vector<int32_t> values;
+                    values.reserve(chunk.size());
+                    for (const auto& row : chunk) {
+                        auto it = codes[c].find(row[c]);
+                        if (it == codes[c].end()) {
+                            it = codes[c].emplace(row[c], (int32_t)dictionaries[c].size()).first;
+                            dictionaries[c].push_back(row[c]);
+                        }
+                        values.push_back(it->second);
+                    }
+                    out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(int32_t));
+                }
+            }
+            row_start += chunk.size();
+        }
+    }
+
+    // Dictionaries after the data sections
+    vector<uint64_t> dictionary_offsets(headers.size(), 0);
+    out.seekp(dictionary_start);
+    for (size_t c = 0; c < headers.size(); ++c) {
+        if (types[c] != "string") continue;
+        dictionary_offsets[c] = out.tellp();
+        for (const auto& value : dictionaries[c]) {
+            write_string(out, value);
+        }
+    }
+
+    // Header last, now that every offset is known
+    out.seekp(0);
+    out.write(COLUMNAR_MAGIC, sizeof(COLUMNAR_MAGIC));
+    write_pod(out, (uint64_t)total_rows);
+    write_pod(out, (uint32_t)headers.size());
+    for (size_t c = 0; c < headers.size(); ++c) {
+        write_string(out, headers[c]);
+        write_pod(out, type_tag(types[c]));
+        write_pod(out, data_offsets[c]);
+        write_pod(out, dictionary_offsets[c]);
+        write_pod(out, (uint64_t)dictionaries[c].size());
+    }
+
+    if (!out) {
+        throw runtime_error("Failed writing columnar file: " + out_path);
+    }
+}
+
+// ==================== Reader ====================
+
+columnar_file::columnar_file(const string& path) {
+    fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("Could not open file: " + path);
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(COLUMNAR_MAGIC)) {
+        close(fd);
+        throw runtime_error("Not a columnar file: " + path);
+    }
+    file_size = info.st_size;
+
+    void* mapping = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+        close(fd);
+        throw runtime_error("Could not memory-map file: " + path);
+    }
+    base = static_cast<const char*>(mapping);
+
+    if (memcmp(base, COLUMNAR_MAGIC, sizeof(COLUMNAR_MAGIC)) != 0) {
+        munmap(const_cast<char*>(base), file_size);
+        close(fd);
+        throw runtime_error("Not a columnar file: " + path);
+    }
+
+    // Every length, count and offset read from the file is checked against the
+    // mapping before it is followed
+    try {
+        const char* end = base + file_size;
+        auto check_bounds = [&](const char* at, uint64_t bytes, const string& what) {
+            if (bytes > (uint64_t)(end - at)) {
+                throw runtime_error("Corrupt columnar file: " + what + " out of bounds");
+            }
+        };
+
+        const char* cursor = base + sizeof(COLUMNAR_MAGIC);
+        check_bounds(cursor, sizeof(uint64_t) + sizeof(uint32_t), "header");
+        num_rows = read_pod<uint64_t>(cursor);
+        uint32_t num_cols = read_pod<uint32_t>(cursor);
+
+        for (uint32_t c = 0; c < num_cols; ++c) {
+            column_info info_c;
+            check_bounds(cursor, sizeof(uint32_t), "column header");
+            uint32_t name_len = read_pod<uint32_t>(cursor);
+            check_bounds(cursor, (uint64_t)name_len + sizeof(uint8_t) + 3 * sizeof(uint64_t), "column header");
+            info_c.name.assign(cursor, name_len);
+            cursor += name_len;
+            info_c.type = tag_type(read_pod<uint8_t>(cursor));
+            info_c.data_offset = read_pod<uint64_t>(cursor);
+            uint64_t dictionary_offset = read_pod<uint64_t>(cursor);
+            uint64_t dictionary_size = read_pod<uint64_t>(cursor);
+
+            if (info_c.data_offset > file_size ||
+                num_rows > (file_size - info_c.data_offset) / type_width(info_c.type)) {
+                throw runtime_error("Corrupt columnar file: column " + info_c.name + " out of bounds");
+            }
+            if (dictionary_offset > file_size) {
+                throw runtime_error("Corrupt columnar file: dictionary of " + info_c.name + " out of bounds");
+            }
+
+            // Dictionaries are small; keep them decoded in memory
+            const char* dict_cursor = base + dictionary_offset;
+            for (uint64_t i = 0; i < dictionary_size; ++i) {
+                check_bounds(dict_cursor, sizeof(uint32_t), "dictionary of " + info_c.name);
+                uint32_t len = read_pod<uint32_t>(dict_cursor);
+                check_bounds(dict_cursor, len, "dictionary of " + info_c.name);
+                info_c.dictionary.emplace_back(dict_cursor, len);
+                dict_cursor += len;
+            }
+            info_c.sorted_categories = info_c.dictionary;
+            sort(info_c.sorted_categories.begin(), info_c.sorted_categories.end());
+
+            // Codes index the dictionary in materialize(), which runs inside parallel regions
+            if (info_c.type == "string") {
+                const int32_t* codes = reinterpret_cast<const int32_t*>(base + info_c.data_offset);
+                for (size_t r = 0; r < num_rows; ++r) {
+                    if (codes[r] < 0 || (size_t)codes[r] >= info_c.dictionary.size()) {
+                        throw runtime_error("Corrupt columnar file: column " + info_c.name + " has a code outside its dictionary");
+                    }
+                }
+            }
+
+            columns.push_back(move(info_c));
+        }
+    } catch (...) {
+        munmap(const_cast<char*>(base), file_size);
+        close(fd);
+        base = nullptr;
+        fd = -1;
+        throw;
+    }
+}
+
+columnar_file::~columnar_file() {
+    if (base) munmap(const_cast<char*>(base), file_size);
+    if (fd >= 0) close(fd);
+}
+
+const columnar_file::column_info& columnar_file::find_column(const string& name) const {
+    for (const auto& column : columns) {
+        if (column.name == name) return column;
+    }
+    throw invalid_argument("Column not found: " + name);
+}
+
+size_t columnar_file::get_num_rows() const {
+    return num_rows;
+}
+
+vector<string> columnar_file::get_column_names() const {
+    vector<string> names;
+    for (const auto& column : columns) names.push_back(column.name);
+    return names;
+}
+
+string columnar_file::get_column_type(const string& name) const {
+    return find_column(name).type;
+}
+
+const vector<string>& columnar_file::get_categories(const string& name) const {
+    return find_column(name).sorted_categories;
+}
+
+int columnar_file::count_classes(const string& target_col) const {
+    const column_info& column = find_column(target_col);
+
+    if (column.type == "string") {
+        return column.dictionary.size();
+    }
+    if (column.type != "int") {
+        throw invalid_argument("Target column must be string or int type");
+    }
+
+    // Streams the whole column once through the mapping
+    const int32_t* data = reinterpret_cast<const int32_t*>(base + column.data_offset);
+    int32_t max_label = 0;
+    for (size_t i = 0; i < num_rows; ++i) {
+        max_label = max(max_label, data[i]);
+    }
+    return max_label + 1;
+}
+
+data_frame columnar_file::materialize(const vector<size_t>& row_indices, const vector<string>& column_names) const {
+    data_frame df;
+
+    for (const auto& name : column_names) {
+        const column_info& column = find_column(name);
+        const char* data = base + column.data_offset;
+
+        if (column.type == "int") {
+            const int32_t* values = reinterpret_cast<const int32_t*>(data);
+            vector<int> out;
+            vector<bool> missing(row_indices.size(), false);
+            out.reserve(row_indices.size());
+            for (size_t i = 0; i < row_indices.size(); ++i) {
+                int32_t value = values[row_indices[i]];
+                missing[i] = value == MISSING_INT;
+                out.push_back(missing[i] ? 0 : value);
+            }
+            df.add_column(name, make_unique<int_col>(out, validity_bitmap(missing)));
+
+        } else if (column.type == "float") {
+            const double* values = reinterpret_cast<const double*>(data);
+            vector<double> out;
+            out.reserve(row_indices.size());
+            for (size_t idx : row_indices) out.push_back(values[idx]);
+            df.add_column(name, make_unique<float_col>(out));
+
+        } else {
+            const int32_t* values = reinterpret_cast<const int32_t*>(data);
+            vector<string> out;
+            out.reserve(row_indices.size());
+            for (size_t idx : row_indices) out.push_back(column.dictionary[values[idx]]);
+            auto str_column = make_unique<string_col>(out);
+            str_column->set_encoding(column.sorted_categories);
+            df.add_column(name, move(str_column));
+        }
+    }
+
+    return df;
+}
@@ -0,0 +1,153 @@
+/*
+Compact (16-bit) forest for serving
+*/
+
+#include "compact_forest.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+void compact_forest::build(const flat_forest& full) {
+    if (full.empty()) {
+        throw runtime_error("Forest not fitted. Call fit() first.");
+    }
+
+    size_t n_features = full.categories.size();
+    if (n_features > FEATURE_MASK || full.num_classes > LEAF) {
+        throw runtime_error("Forest too large for the compact variant (16-bit feature/class ids)");
+    }
+
+    nodes.clear();
+    roots.clear();
+    num_classes = full.num_classes;
+
+    leaf_probabilities.clear();
+    for (double p : full.leaf_probabilities) {
+        leaf_probabilities.push_back((uint16_t)lround(p * 65535.0));
+    }
+
+    // A feature is categorical if any split on it is (the schema never mixes)
+    is_categorical.assign(n_features, false);
+    split_points.assign(n_features, vector<double>());
+    for (const auto& node : full.nodes) {
+        if (node.feature_idx < 0) continue;
+        if (node.is_categorical) {
+            is_categorical[node.feature_idx] = true;
+        } else {
+            split_points[node.feature_idx].push_back(node.threshold);
+        }
+    }
+
+    for (size_t f = 0; f < n_features; ++f) {
+        auto& points = split_points[f];
+        sort(points.begin(), points.end());
+        points.erase(unique(points.begin(), points.end()), points.end());
+        if (points.size() >= MISSING_BIN || full.categories[f].size() >= MISSING_BIN) {
+            throw runtime_error("Forest too large for the compact variant (over 65534 split points on a feature)");
+        }
+    }
+
+    for (int root : full.roots) {
+        roots.push_back(append_node(full, root));
+    }
+}
+
+uint32_t compact_forest::append_node(const flat_forest& full, int node_idx) {
+    const auto& node = full.nodes[node_idx];
+    uint32_t idx = nodes.size();
+    nodes.push_back(compact_node());
+
+    compact_node compact;
+    if (node.feature_idx < 0) {
+        compact.feature = LEAF;
+        compact.value = node.predicted_class;
+        compact.right_or_leaf = node.leaf_offset < 0 ? ONE_HOT : node.leaf_offset;
+    } else {
+        compact.feature = node.feature_idx;
+        if (node.is_categorical) {
+            compact.feature |= CATEGORICAL;
+            compact.value = (uint16_t)node.threshold;
+        } else {
+            const auto& points = split_points[node.feature_idx];
+            compact.value = lower_bound(points.begin(), points.end(), node.threshold) - points.begin();
+            if (node.missing_left) compact.feature |= MISSING_LEFT;
+        }
+
+        append_node(full, node.left);  // Always idx + 1 in preorder
+        compact.right_or_leaf = append_node(full, node.right);
+    }
+
+    nodes[idx] = compact;
+    return idx;
+}
+
+bool compact_forest::empty() const {
+    return roots.empty();
+}
+
+int compact_forest::get_num_classes() const {
+    return num_classes;
+}
+
+size_t compact_forest::memory_bytes() const {
+    size_t bytes = nodes.size() * sizeof(compact_node) + roots.size() * sizeof(uint32_t) +
+                   leaf_probabilities.size() * sizeof(uint16_t);
+    for (const auto& points : split_points) bytes += points.size() * sizeof(double);
+    return bytes;
+}
+
+int compact_forest::predict_row(const double* row, double* proba_out) const {
+    // Per-thread buffers: sized once, reused by every later call
+    thread_local vector<uint16_t> bins;
+    thread_local vector<uint32_t> sums;
+    thread_local vector<int> votes;
+
+    // Map the row onto split bins once; every node then compares two uint16
+    size_t n_features = split_points.size();
+    bins.resize(n_features);
+    for (size_t f = 0; f < n_features; ++f) {
+        double value = row[f];
+        if (std::isnan(value)) {
+            bins[f] = MISSING_BIN;
+        } else if (is_categorical[f]) {
+            // Unseen (-1) or non-code values match no category
+            bool is_code = value >= 0 && value < MISSING_BIN && value == floor(value);
+            bins[f] = is_code ? (uint16_t)value : MISSING_BIN;
+        } else {
+            const auto& points = split_points[f];
+            bins[f] = lower_bound(points.begin(), points.end(), value) - points.begin();
+        }
+    }
+
+    sums.assign(num_classes, 0);
+    votes.assign(num_classes, 0);
+    const compact_node* base = nodes.data();
+    for (uint32_t root : roots) {
+        const compact_node* node = base + root;
+        while (node->feature != LEAF) {
+            uint16_t bin = bins[node->feature & FEATURE_MASK];
+            bool go_left = (node->feature & CATEGORICAL) ? (bin == node->value)
+                         : (bin <= node->value || (bin == MISSING_BIN && (node->feature & MISSING_LEFT)));
+            node = go_left ? node + 1 : base + node->right_or_leaf;
+        }
+
+        votes[node->value]++;
+        if (node->right_or_leaf == ONE_HOT) {
+            sums[node->value] += 65535;
+        } else {
+            const uint16_t* probabilities = leaf_probabilities.data() + node->right_or_leaf;
+            for (int c = 0; c < num_classes; ++c) {
+                sums[c] += probabilities[c];
+            }
+        }
+    }
+
+    double scale = roots.empty() ? 0.0 : 1.0 / (65535.0 * roots.size());
+    for (int c = 0; c < num_classes; ++c) {
+        proba_out[c] = sums[c] * scale;
+    }
+
+    return max_element(votes.begin(), votes.end()) - votes.begin();
+}
@@ -0,0 +1,160 @@
+/*
+K-fold cross-validation with shared data and parallel folds
+*/
+
+#include "cross_validation.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <omp.h>
+
+using namespace std;
+
+vector<kfold_split> make_kfold_splits(const vector<size_t>& rows, int num_folds, unsigned int seed) {
+    if (num_folds < 2) {
+        throw invalid_argument("num_folds must be at least 2");
+    }
+    if (rows.size() < (size_t)num_folds) {
+        throw invalid_argument("Not enough rows for " + to_string(num_folds) + " folds");
+    }
+
+    vector<size_t> shuffled = rows;
+    mt19937 rng(seed);
+    shuffle(shuffled.begin(), shuffled.end(), rng);
+
+    vector<kfold_split> splits(num_folds);
+    for (size_t i = 0; i < shuffled.size(); ++i) {
+        int fold = i % num_folds;
+        splits[fold].test_indices.push_back(shuffled[i]);
+        for (int other = 0; other < num_folds; ++other) {
+            if (other != fold) splits[other].train_indices.push_back(shuffled[i]);
+        }
+    }
+
+    return splits;
+}
+
+vector<int> encoded_targets(const data_frame& df, const string& target_col) {
+    const col* target_column = df.get_column(target_col);
+    if (!target_column) {
+        throw invalid_argument("Target column not found: " + target_col);
+    }
+
+    vector<int> labels;
+    labels.reserve(df.get_num_rows());
+
+    if (auto str_target = dynamic_cast<const string_col*>(target_column)) {
+        if (!str_target->has_encoding()) {
+            str_target->fit_encoding();
+        }
+        for (size_t i = 0; i < df.get_num_rows(); ++i) {
+            labels.push_back(str_target->get_encoded(i));
+        }
+    } else if (auto int_target = dynamic_cast<const int_col*>(target_column)) {
+        for (size_t i = 0; i < df.get_num_rows(); ++i) {
+            labels.push_back(int_target->is_missing(i) ? -1 : int_target->get(i));
+        }
+    } else {
+        throw invalid_argument("Target column must be string or int type");
+    }
+
+    return labels;
+}
+
+cv_result cross_validator::run(
+    const data_frame& df,
+    const vector<string>& feature_cols,
+    const string& target_col
+) const {
+    if (!config || !rf_config) {
+        throw runtime_error("cv_config and random_forest_config must be set before calling run().");
+    }
+
+    // Shared across folds: encoded labels (and the fitted target encoding) and the fold
+    // views, which leave out rows without a target
+    vector<int> labels = encoded_targets(df, target_col);
+    vector<kfold_split> splits = make_kfold_splits(df.present_rows(target_col), config->num_folds, config->seed);
+
+    int k = config->num_folds;
+    vector<fold_result> folds(k);
+
+    auto wall_start = chrono::high_resolution_clock::now();
+
+    // Exceptions cannot leave the parallel region, so each fold records its own
+    vector<exception_ptr> fold_errors(k);
+    #pragma omp parallel for schedule(dynamic, 1) if(config->use_parallel)
+    for (int fold = 0; fold < k; ++fold) {
+        try {
+            const kfold_split& split = splits[fold];
+
+            // Per-fold copies so folds never share mutable config
+            tree_hyperparameters hp = hp_config ? *hp_config : tree_hyperparameters();
+            tree_growing_config growing = growing_config ? *growing_config : tree_growing_config();
+            random_forest_config forest_config = *rf_config;
+            if (config->use_parallel) {
+                growing.use_parallel = false;
+                forest_config.use_parallel = false;
+            }
+
+            random_forest forest;
+            forest.hp_config = &hp;
+            forest.growing_config = &growing;
+            forest.rf_config = &forest_config;
+
+            auto train_start = chrono::high_resolution_clock::now();
+            forest.fit(df, feature_cols, target_col, &split.train_indices);
+            auto train_end = chrono::high_resolution_clock::now();
+            vector<int> predictions = forest.predict(df, split.test_indices);
+            auto predict_end = chrono::high_resolution_clock::now();
+
+            vector<int> truth;
+            truth.reserve(split.test_indices.size());
+            for (size_t idx : split.test_indices) {
+                truth.push_back(labels[idx]);
+            }
+
+            fold_result& result = folds[fold];
+            result.fold = fold;
+            result.train_rows = split.train_indices.size();
+            result.test_rows = split.test_indices.size();
+            result.train_time_ms = chrono::duration<double, milli>(train_end - train_start).count();
+            result.predict_time_ms = chrono::duration<double, milli>(predict_end - train_end).count();
+            classification_report report = metrics::report(predictions, truth);
+            result.accuracy = report.accuracy;
+            result.precision = report.macro_precision;
+            result.recall = report.macro_recall;
+            result.f1_score = metrics::f1_score(report);
+        } catch (...) {
+            fold_errors[fold] = current_exception();
+        }
+    }
+
+    for (const exception_ptr& error : fold_errors) {
+        if (error) rethrow_exception(error);
+    }
+
+    auto wall_end = chrono::high_resolution_clock::now();
+
+    // Aggregate
+    cv_result summary;
+    summary.folds = folds;
+    summary.mean_accuracy = 0.0;
+    summary.mean_f1_score = 0.0;
+    for (const auto& fold : folds) {
+        summary.mean_accuracy += fold.accuracy / k;
+        summary.mean_f1_score += fold.f1_score / k;
+    }
+
+    double variance = 0.0;
+    for (const auto& fold : folds) {
+        variance += (fold.accuracy - summary.mean_accuracy) * (fold.accuracy - summary.mean_accuracy);
+    }
+    summary.stddev_accuracy = sqrt(variance / k);
+    summary.wall_time_ms = chrono::duration<double, milli>(wall_end - wall_start).count();
+
+    return summary;
+}
@@ -3,15 +3,29 @@ Serial Decision Tree implementation
 */
 
 #include "decision_tree.hpp"
+#include "profiler.hpp"
+#include "metrics_registry.hpp"
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <numeric>
 #include <limits>
 #include <stdexcept>
+#include <map>
 #include <set>
+#include <tuple>
 #include <omp.h>
 
 using namespace std;
 
+// Runtime metrics (exported by metrics_exporter)
+static metric_counter& nodes_built = metrics_registry::global().get_counter(
+    "prf_tree_nodes_built_total", "Decision tree nodes created");
+static metric_counter& split_evaluations = metrics_registry::global().get_counter(
+    "prf_split_evaluations_total", "Candidate splits scored");
+static metric_histogram& tree_fit_seconds = metrics_registry::global().get_histogram(
+    "prf_tree_fit_seconds", "Time to fit one decision tree", metric_histogram::exponential_bounds(0.001, 2.0, 16));
+
 // Helper: Determine if we should parallelize at this node
 static bool should_parallelize(
     int current_depth,
@@ -34,6 +48,27 @@ static bool should_parallelize(
     return true;
 }
 
+// Helper: Read a numerical feature value, false if the row is missing it
+static bool read_numeric(const col* column, size_t idx, double& value) {
+    if (auto int_column = dynamic_cast<const int_col*>(column)) {
+        value = static_cast<double>(int_column->get(idx));
+        return !int_column->is_missing(idx);
+    }
+    if (auto float_column = dynamic_cast<const float_col*>(column)) {
+        value = float_column->get(idx);
+        return !std::isnan(value);
+    }
+    throw runtime_error("Expected numerical column for numerical split");
+}
+
+// Helper: Sample weight of a row (NaN when the weight is missing)
+static double read_weight(const col* column, size_t idx) {
+    if (auto int_column = dynamic_cast<const int_col*>(column)) {
+        return int_column->is_missing(idx) ? numeric_limits<double>::quiet_NaN() : int_column->get(idx);
+    }
+    return static_cast<const float_col*>(column)->get(idx);
+}
+
 // ==================== Training ====================
 
 void decision_tree::fit(
@@ -52,6 +87,7 @@ void decision_tree::fit(
     }
     
     // Handle string targets - fit encoding
+    regression = false;
     if (auto str_target = dynamic_cast<const string_col*>(target_column)) {
         if (!str_target->has_encoding()) {
             str_target->fit_encoding();
@@ -61,9 +97,14 @@ void decision_tree::fit(
         // For int targets, find max value
         const auto& data = int_target->get_data();
         num_classes = *max_element(data.begin(), data.end()) + 1;
+    } else if (dynamic_cast<const float_col*>(target_column)) {
+        // Regression: a single "class" whose probability slot holds the leaf mean
+        regression = true;
+        num_classes = 1;
     } else {
-        throw invalid_argument("Target column must be string or int type");
+        throw invalid_argument("Target column must be string, int or float type");
     }
+    num_classes = max(num_classes, min_num_classes);
     
     // Set up indices
     vector<size_t> indices;
@@ -74,6 +115,59 @@ void decision_tree::fit(
         indices = *bootstrap_indices;
     }
     
+    // Rows without a target cannot be learned from
+    auto int_target = dynamic_cast<const int_col*>(target_column);
+    auto float_target = dynamic_cast<const float_col*>(target_column);
+    if ((int_target && int_target->missing_count() > 0) || (float_target && float_target->missing_count() > 0)) {
+        indices.erase(remove_if(indices.begin(), indices.end(), [&](size_t idx) {
+            return int_target ? int_target->is_missing(idx) : float_target->is_missing(idx);
+        }), indices.end());
+    }
+    if (indices.empty()) {
+        throw invalid_argument("No rows with a target value to fit on: " + target_col);
+    }
+    
+    // Resolve sample and class weights for this tree's rows
+    weight_col = nullptr;
+    fit_class_weights.clear();
+    if (growing_config && !growing_config->weight_column.empty()) {
+        const string& weight_name = growing_config->weight_column;
+        weight_col = df.get_column(weight_name);
+        if (!dynamic_cast<const int_col*>(weight_col) && !dynamic_cast<const float_col*>(weight_col)) {
+            throw invalid_argument("Sample weight column must be a numeric column: " + weight_name);
+        }
+        for (size_t idx : indices) {
+            if (!(read_weight(weight_col, idx) >= 0.0)) {
+                throw invalid_argument("Sample weights must be non-negative numbers (" + weight_name +
+                                       ", row " + to_string(idx) + ")");
+            }
+        }
+    }
+    if (growing_config && !regression && growing_config->balance_classes) {
+        // total / (k * class total) over the classes present, so every class weighs the same
+        auto str_target = dynamic_cast<const string_col*>(target_column);
+        vector<double> class_totals(num_classes, 0.0);
+        for (size_t idx : indices) {
+            int label = str_target ? str_target->get_encoded(idx) : int_target->get(idx);
+            class_totals[label] += weight_col ? read_weight(weight_col, idx) : 1.0;
+        }
+        double total = accumulate(class_totals.begin(), class_totals.end(), 0.0);
+        int present = count_if(class_totals.begin(), class_totals.end(), [](double w) { return w > 0.0; });
+        fit_class_weights.assign(num_classes, 1.0);
+        for (int c = 0; c < num_classes; ++c) {
+            if (class_totals[c] > 0.0) fit_class_weights[c] = total / (present * class_totals[c]);
+        }
+    } else if (growing_config && !regression && !growing_config->class_weights.empty()) {
+        fit_class_weights = growing_config->class_weights;
+        if ((int)fit_class_weights.size() != num_classes) {
+            throw invalid_argument("Expected " + to_string(num_classes) + " class weights, got " +
+                                   to_string(fit_class_weights.size()));
+        }
+        for (double weight : fit_class_weights) {
+            if (!(weight >= 0.0)) throw invalid_argument("Class weights must be non-negative");
+        }
+    }
+    
     // Initialize progress tracker if provided
     if (progress_tracker) {
         int max_d = (hp_config ? hp_config->max_depth : -1);
@@ -81,7 +175,11 @@ void decision_tree::fit(
         progress_tracker->initialize(max_d, min_samples, indices.size());
     }
     
+    feature_importances.assign(feature_cols.size(), 0.0);
+    
     // Build tree recursively
+    PRF_PROFILE_SCOPE(TREE_FIT);
+    auto fit_start = chrono::steady_clock::now();
     if (growing_config && growing_config->use_parallel) {
         // Create parallel region for task-based parallelism
         #pragma omp parallel
@@ -95,6 +193,13 @@ void decision_tree::fit(
         // Sequential execution
         root = build_tree(df, indices, 0);
     }
+    tree_fit_seconds.observe(chrono::duration<double>(chrono::steady_clock::now() - fit_start).count());
+    weight_col = nullptr;
+    
+    double total_decrease = accumulate(feature_importances.begin(), feature_importances.end(), 0.0);
+    if (total_decrease > 0.0) {
+        for (double& importance : feature_importances) importance /= total_decrease;
+    }
     
     // Mark progress as complete
     if (progress_tracker) {
@@ -109,37 +214,61 @@ unique_ptr<decision_tree::TreeNode> decision_tree::build_tree(
     const vector<size_t>& indices,
     int current_depth
 ) {
-    auto node = make_unique<TreeNode>();
+    unique_ptr<TreeNode> node;
+    {
+        PRF_PROFILE_SCOPE(NODE_ALLOC);
+        node = make_unique<TreeNode>();
+    }
     
     // Track node creation
+    nodes_built.add();
     if (progress_tracker) {
         progress_tracker->increment_nodes();
     }
     
-    // Get encoded labels for these indices
+    // Get encoded labels (regression: target values) for these indices
     const col* target_col = df.get_column(target_column_name);
     vector<int> encoded_labels;
-    
-    if (auto str_target = dynamic_cast<const string_col*>(target_col)) {
-        for (size_t idx : indices) {
-            encoded_labels.push_back(str_target->get_encoded(idx));
-        }
-    } else if (auto int_target = dynamic_cast<const int_col*>(target_col)) {
-        const auto& data = int_target->get_data();
-        for (size_t idx : indices) {
-            encoded_labels.push_back(data[idx]);
+    vector<double> targets;
+    vector<double> weights;
+    {
+        PRF_PROFILE_SCOPE(LABEL_GATHER);
+        if (auto str_target = dynamic_cast<const string_col*>(target_col)) {
+            for (size_t idx : indices) {
+                encoded_labels.push_back(str_target->get_encoded(idx));
+            }
+        } else if (auto int_target = dynamic_cast<const int_col*>(target_col)) {
+            const auto& data = int_target->get_data();
+            for (size_t idx : indices) {
+                encoded_labels.push_back(data[idx]);
+            }
+        } else if (auto float_target = dynamic_cast<const float_col*>(target_col)) {
+            const auto& data = float_target->get_data();
+            for (size_t idx : indices) {
+                targets.push_back(data[idx]);
+            }
         }
+        weights = row_weights(indices, encoded_labels);
     }
     
     // Check stopping conditions
     
-    // 1. Check if node is pure (all same class)
+    // 1. Check if node is pure (all same class / same target value)
     bool is_pure = true;
-    int first_label = encoded_labels[0];
-    for (int label : encoded_labels) {
-        if (label != first_label) {
-            is_pure = false;
-            break;
+    if (regression) {
+        for (double target : targets) {
+            if (target != targets[0]) {
+                is_pure = false;
+                break;
+            }
+        }
+    } else {
+        int first_label = encoded_labels[0];
+        for (int label : encoded_labels) {
+            if (label != first_label) {
+                is_pure = false;
+                break;
+            }
         }
     }
     
@@ -154,18 +283,8 @@ unique_ptr<decision_tree::TreeNode> decision_tree::build_tree(
     
     // If stopping condition met, create leaf
     if (is_pure || max_depth_reached || min_samples_reached || indices.size() == 1) {
-        node->is_leaf = true;
-        
-        // Calculate class probabilities
-        vector<int> counts = metrics::class_counts(encoded_labels, num_classes);
-        node->class_probabilities.resize(num_classes);
-        for (int c = 0; c < num_classes; ++c) {
-            node->class_probabilities[c] = static_cast<double>(counts[c]) / encoded_labels.size();
-        }
-        
-        // Set predicted class (majority)
-        node->predicted_class = max_element(counts.begin(), counts.end()) - counts.begin();
-        
+        PRF_PROFILE_SCOPE(NODE_ALLOC);
+        fill_leaf(node.get(), encoded_labels, targets, weights);
         return node;
     }
     
@@ -174,45 +293,55 @@ unique_ptr<decision_tree::TreeNode> decision_tree::build_tree(
     int best_feature_idx = -1;
     bool best_is_categorical = false;
     double best_threshold = 0.0;
+    bool best_missing_left = false;
     string best_split_value;
     
-    for (int feat_idx = 0; feat_idx < (int)feature_names.size(); ++feat_idx) {
-        const string& feat_name = feature_names[feat_idx];
-        const col* feat_col = df.get_column(feat_name);
+    {
+        PRF_PROFILE_SCOPE(SPLIT_SEARCH);
+        for (int feat_idx = 0; feat_idx < (int)feature_names.size(); ++feat_idx) {
+            const string& feat_name = feature_names[feat_idx];
+            const col* feat_col = df.get_column(feat_name);
         
-        if (dynamic_cast<const string_col*>(feat_col)) {
-            // Categorical feature
-            auto [gain, split_val] = find_best_categorical_split(df, indices, feat_idx, encoded_labels);
-            if (gain > best_overall_gain) {
-                best_overall_gain = gain;
-                best_feature_idx = feat_idx;
-                best_is_categorical = true;
-                best_split_value = split_val;
-            }
-        } else {
-            // Numerical feature
-            auto [gain, threshold] = find_best_numerical_split(df, indices, feat_idx, encoded_labels);
-            if (gain > best_overall_gain) {
-                best_overall_gain = gain;
-                best_feature_idx = feat_idx;
-                best_is_categorical = false;
-                best_threshold = threshold;
+            if (dynamic_cast<const string_col*>(feat_col)) {
+                // Categorical feature
+                auto [gain, split_val] = regression
+                    ? find_best_categorical_regression_split(df, indices, feat_idx, targets, weights)
+                    : find_best_categorical_split(df, indices, feat_idx, encoded_labels, weights);
+                if (gain > best_overall_gain) {
+                    best_overall_gain = gain;
+                    best_feature_idx = feat_idx;
+                    best_is_categorical = true;
+                    best_split_value = split_val;
+                }
+            } else {
+                // Numerical feature
+                numeric_split split = regression
+                    ? find_best_numerical_regression_split(df, indices, feat_idx, targets, weights)
+                    : find_best_numerical_split(df, indices, feat_idx, encoded_labels, weights);
+                if (split.gain > best_overall_gain) {
+                    best_overall_gain = split.gain;
+                    best_feature_idx = feat_idx;
+                    best_is_categorical = false;
+                    best_threshold = split.threshold;
+                    best_missing_left = split.missing_left;
+                }
             }
         }
     }
     
     // If no valid split found, create leaf
     if (best_feature_idx == -1 || best_overall_gain <= 0.0) {
-        node->is_leaf = true;
-        vector<int> counts = metrics::class_counts(encoded_labels, num_classes);
-        node->class_probabilities.resize(num_classes);
-        for (int c = 0; c < num_classes; ++c) {
-            node->class_probabilities[c] = static_cast<double>(counts[c]) / encoded_labels.size();
-        }
-        node->predicted_class = max_element(counts.begin(), counts.end()) - counts.begin();
+        PRF_PROFILE_SCOPE(NODE_ALLOC);
+        fill_leaf(node.get(), encoded_labels, targets, weights);
         return node;
     }
     
+    // Impurity decrease of this split, weighted by the node's total row weight
+    // (subtree tasks may update concurrently)
+    double decrease = accumulate(weights.begin(), weights.end(), 0.0) * best_overall_gain;
+    #pragma omp atomic
+    feature_importances[best_feature_idx] += decrease;
+    
     // Create internal node with best split
     node->is_leaf = false;
     node->feature_idx = best_feature_idx;
@@ -222,40 +351,47 @@ unique_ptr<decision_tree::TreeNode> decision_tree::build_tree(
         node->split_value = best_split_value;
     } else {
         node->threshold = best_threshold;
+        node->missing_left = best_missing_left;
     }
     
     // Split indices
     vector<size_t> left_indices, right_indices;
-    const string& split_feat_name = feature_names[best_feature_idx];
-    const col* split_feat_col = df.get_column(split_feat_name);
-    
-    if (best_is_categorical) {
-        const string_col* str_col = dynamic_cast<const string_col*>(split_feat_col);
-        const auto& data = str_col->get_data();
-        for (size_t idx : indices) {
-            if (data[idx] == best_split_value) {
-                left_indices.push_back(idx);
-            } else {
-                right_indices.push_back(idx);
-            }
-        }
-    } else {
-        if (auto int_col_ptr = dynamic_cast<const int_col*>(split_feat_col)) {
-            const auto& data = int_col_ptr->get_data();
+    {
+        PRF_PROFILE_SCOPE(PARTITION);
+        const string& split_feat_name = feature_names[best_feature_idx];
+        const col* split_feat_col = df.get_column(split_feat_name);
+    
+        if (best_is_categorical) {
+            const string_col* str_col = dynamic_cast<const string_col*>(split_feat_col);
+            const auto& data = str_col->get_data();
             for (size_t idx : indices) {
-                if (static_cast<double>(data[idx]) <= best_threshold) {
+                if (data[idx] == best_split_value) {
                     left_indices.push_back(idx);
                 } else {
                     right_indices.push_back(idx);
                 }
             }
-        } else if (auto float_col_ptr = dynamic_cast<const float_col*>(split_feat_col)) {
-            const auto& data = float_col_ptr->get_data();
-            for (size_t idx : indices) {
-                if (data[idx] <= best_threshold) {
-                    left_indices.push_back(idx);
-                } else {
-                    right_indices.push_back(idx);
+        } else {
+            if (auto int_col_ptr = dynamic_cast<const int_col*>(split_feat_col)) {
+                const auto& data = int_col_ptr->get_data();
+                for (size_t idx : indices) {
+                    bool go_left = int_col_ptr->is_missing(idx) ? best_missing_left
+                                                                : static_cast<double>(data[idx]) <= best_threshold;
+                    if (go_left) {
+                        left_indices.push_back(idx);
+                    } else {
+                        right_indices.push_back(idx);
+                    }
+                }
+            } else if (auto float_col_ptr = dynamic_cast<const float_col*>(split_feat_col)) {
+                const auto& data = float_col_ptr->get_data();
+                for (size_t idx : indices) {
+                    bool go_left = std::isnan(data[idx]) ? best_missing_left : data[idx] <= best_threshold;
+                    if (go_left) {
+                        left_indices.push_back(idx);
+                    } else {
+                        right_indices.push_back(idx);
+                    }
                 }
             }
         }
@@ -282,7 +418,10 @@ unique_ptr<decision_tree::TreeNode> decision_tree::build_tree(
             }
         }
         
-        #pragma omp taskwait  // Wait for both tasks to complete
+        {
+            PRF_PROFILE_SCOPE(TASK_WAIT);
+            #pragma omp taskwait  // Wait for both tasks to complete
+        }
         
         node->left = move(left_child);
         node->right = move(right_child);
@@ -300,132 +439,346 @@ unique_ptr<decision_tree::TreeNode> decision_tree::build_tree(
     return node;
 }
 
-pair<double, double> decision_tree::find_best_numerical_split(
+vector<double> decision_tree::row_weights(const vector<size_t>& indices, const vector<int>& encoded_labels) const {
+    vector<double> weights(indices.size(), 1.0);
+    if (weight_col) {
+        for (size_t i = 0; i < indices.size(); ++i) {
+            weights[i] = read_weight(weight_col, indices[i]);
+        }
+    }
+    if (!fit_class_weights.empty()) {
+        for (size_t i = 0; i < indices.size(); ++i) {
+            weights[i] *= fit_class_weights[encoded_labels[i]];
+        }
+    }
+    return weights;
+}
+
+void decision_tree::fill_leaf(TreeNode* node, const vector<int>& encoded_labels, const vector<double>& targets,
+                              const vector<double>& weights) const {
+    node->is_leaf = true;
+    
+    // All-zero weights fall back to plain row counts
+    double total_weight = accumulate(weights.begin(), weights.end(), 0.0);
+    bool weighted = total_weight > 0.0;
+    
+    if (regression) {
+        double sum = 0.0;
+        for (size_t i = 0; i < targets.size(); ++i) {
+            sum += weighted ? weights[i] * targets[i] : targets[i];
+        }
+        node->class_probabilities.assign(1, sum / (weighted ? total_weight : targets.size()));
+        node->predicted_class = 0;
+        return;
+    }
+    
+    // Calculate class probabilities (weighted class shares)
+    vector<double> counts = weighted ? metrics::weighted_class_counts(encoded_labels, weights, num_classes)
+                                     : metrics::weighted_class_counts(encoded_labels, vector<double>(encoded_labels.size(), 1.0), num_classes);
+    double total = weighted ? total_weight : encoded_labels.size();
+    node->class_probabilities.resize(num_classes);
+    for (int c = 0; c < num_classes; ++c) {
+        node->class_probabilities[c] = counts[c] / total;
+    }
+    
+    // Set predicted class (weighted majority)
+    node->predicted_class = max_element(counts.begin(), counts.end()) - counts.begin();
+}
+
+decision_tree::numeric_split decision_tree::find_best_numerical_split(
     const data_frame& df,
     const vector<size_t>& indices,
     int feature_idx,
-    const vector<int>& encoded_labels
+    const vector<int>& encoded_labels,
+    const vector<double>& weights
 ) {
     const string& feature_name = feature_names[feature_idx];
     
     // Get feature column
     const col* feature_col = df.get_column(feature_name);
     
-    // Collect feature values and labels
-    vector<pair<double, int>> values_and_labels;
-    
-    if (auto int_feat = dynamic_cast<const int_col*>(feature_col)) {
-        const auto& data = int_feat->get_data();
+    // Collect (feature value, position in indices); rows missing the feature
+    // only add their weight to missing_weights
+    vector<pair<double, size_t>> sorted_rows;
+    vector<double> missing_weights(num_classes, 0.0);
+    bool any_missing = false;
+    {
+        PRF_PROFILE_SCOPE(SORT);
+        sorted_rows.reserve(indices.size());
         for (size_t i = 0; i < indices.size(); ++i) {
-            values_and_labels.push_back({static_cast<double>(data[indices[i]]), encoded_labels[i]});
-        }
-    } else if (auto float_feat = dynamic_cast<const float_col*>(feature_col)) {
-        const auto& data = float_feat->get_data();
-        for (size_t i = 0; i < indices.size(); ++i) {
-            values_and_labels.push_back({data[indices[i]], encoded_labels[i]});
+            double value;
+            if (read_numeric(feature_col, indices[i], value)) {
+                sorted_rows.push_back({value, i});
+            } else {
+                missing_weights[encoded_labels[i]] += weights[i];
+                any_missing = true;
+            }
         }
-    } else {
-        throw runtime_error("Expected numerical column for numerical split");
+    
+        // Sort by feature value
+        sort(sorted_rows.begin(), sorted_rows.end());
     }
     
-    // Sort by feature value
-    sort(values_and_labels.begin(), values_and_labels.end());
+    PRF_PROFILE_SCOPE(SPLIT_SCORING);
     
-    double best_gain = -numeric_limits<double>::infinity();
-    double best_threshold = 0.0;
+    numeric_split best = {-numeric_limits<double>::infinity(), 0.0, false};
+    if (sorted_rows.empty()) return best;
     
-    // Collect all labels for parent
-    vector<int> parent_labels;
-    for (const auto& p : values_and_labels) {
-        parent_labels.push_back(p.second);
+    // Class weight totals of the rows with a value, and of the whole node
+    vector<double> present_weights(num_classes, 0.0);
+    for (const auto& row : sorted_rows) {
+        present_weights[encoded_labels[row.second]] += weights[row.second];
+    }
+    vector<double> parent_weights(num_classes);
+    for (int c = 0; c < num_classes; ++c) {
+        parent_weights[c] = present_weights[c] + missing_weights[c];
     }
     
-    // Try each possible split point
-    for (size_t i = 0; i < values_and_labels.size() - 1; ++i) {
+    bool use_gini = growing_config && growing_config->criterion == tree_growing_config::SplitCriterion::GINI;
+    auto split_gain = [&](const vector<double>& left_weights, const vector<double>& right_weights) {
+        return use_gini ? metrics::gini_gain(parent_weights, left_weights, right_weights)
+                        : metrics::entropy_gain(parent_weights, left_weights, right_weights);
+    };
+    
+    // Sweep split points left to right, moving one row at a time into the left side
+    vector<double> left_weights(num_classes, 0.0), right_weights(num_classes);
+    vector<double> left_with_missing(num_classes), right_with_missing(num_classes);
+    uint64_t evaluated = 0;
+    for (size_t i = 0; i + 1 < sorted_rows.size(); ++i) {
+        size_t pos = sorted_rows[i].second;
+        left_weights[encoded_labels[pos]] += weights[pos];
+        
         // Skip if same value
-        if (values_and_labels[i].first == values_and_labels[i + 1].first) {
+        if (sorted_rows[i].first == sorted_rows[i + 1].first) {
             continue;
         }
         
-        double threshold = (values_and_labels[i].first + values_and_labels[i + 1].first) / 2.0;
-        
-        // Split labels
-        vector<int> left_labels, right_labels;
-        for (size_t j = 0; j <= i; ++j) {
-            left_labels.push_back(values_and_labels[j].second);
-        }
-        for (size_t j = i + 1; j < values_and_labels.size(); ++j) {
-            right_labels.push_back(values_and_labels[j].second);
+        double threshold = (sorted_rows[i].first + sorted_rows[i + 1].first) / 2.0;
+        for (int c = 0; c < num_classes; ++c) {
+            right_weights[c] = present_weights[c] - left_weights[c];
         }
         
-        // Calculate gain based on criterion
-        double gain = 0.0;
-        if (growing_config && growing_config->criterion == tree_growing_config::SplitCriterion::GINI) {
-            gain = metrics::gini_gain(parent_labels, left_labels, right_labels, num_classes);
-        } else { // SHANNON_ENTROPY or no config
-            gain = metrics::entropy_gain(parent_labels, left_labels, right_labels, num_classes);
+        // Calculate gain, with missing rows sent to each side in turn
+        double gain;
+        bool missing_left;
+        if (!any_missing) {
+            gain = split_gain(left_weights, right_weights);
+            missing_left = i + 1 >= sorted_rows.size() - (i + 1);
+        } else {
+            for (int c = 0; c < num_classes; ++c) {
+                left_with_missing[c] = left_weights[c] + missing_weights[c];
+                right_with_missing[c] = right_weights[c] + missing_weights[c];
+            }
+            double gain_left = split_gain(left_with_missing, right_weights);
+            double gain_right = split_gain(left_weights, right_with_missing);
+            
+            missing_left = gain_left >= gain_right;
+            gain = max(gain_left, gain_right);
         }
         
-        if (gain > best_gain) {
-            best_gain = gain;
-            best_threshold = threshold;
+        evaluated++;
+        if (gain > best.gain) {
+            best = {gain, threshold, missing_left};
         }
     }
+    split_evaluations.add(evaluated);
     
-    return {best_gain, best_threshold};
+    return best;
 }
 
 pair<double, string> decision_tree::find_best_categorical_split(
     const data_frame& df,
     const vector<size_t>& indices,
     int feature_idx,
-    const vector<int>& encoded_labels
+    const vector<int>& encoded_labels,
+    const vector<double>& weights
 ) {
     const string& feature_name = feature_names[feature_idx];
     const string_col* feature_col = df.get_string_column(feature_name);
     const auto& data = feature_col->get_data();
-    
-    // Get unique values
-    set<string> unique_values;
-    for (size_t idx : indices) {
-        unique_values.insert(data[idx]);
+    PRF_PROFILE_SCOPE(SPLIT_SCORING);
+    
+    // Per category: rows and class weight totals
+    struct category_weights {
+        size_t rows = 0;
+        vector<double> class_weights;
+    };
+    map<string, category_weights> categories;
+    vector<double> parent_weights(num_classes, 0.0);
+    for (size_t i = 0; i < indices.size(); ++i) {
+        category_weights& category = categories[data[indices[i]]];
+        if (category.class_weights.empty()) category.class_weights.assign(num_classes, 0.0);
+        category.rows++;
+        category.class_weights[encoded_labels[i]] += weights[i];
+        parent_weights[encoded_labels[i]] += weights[i];
     }
     
     double best_gain = -numeric_limits<double>::infinity();
     string best_value;
     
-    // Collect parent labels (encoded_labels is indexed by position in indices, not absolute index)
-    vector<int> parent_labels = encoded_labels;
-    
     // Try each unique value as split (one-vs-rest)
-    for (const string& split_val : unique_values) {
-        vector<int> left_labels, right_labels;
+    bool use_gini = growing_config && growing_config->criterion == tree_growing_config::SplitCriterion::GINI;
+    vector<double> right_weights(num_classes);
+    uint64_t evaluated = 0;
+    for (const auto& [split_val, category] : categories) {
+        // Skip if split doesn't divide
+        if (category.rows == indices.size()) continue;
         
+        for (int c = 0; c < num_classes; ++c) {
+            right_weights[c] = parent_weights[c] - category.class_weights[c];
+        }
+        
+        // Calculate gain
+        double gain = use_gini ? metrics::gini_gain(parent_weights, category.class_weights, right_weights)
+                               : metrics::entropy_gain(parent_weights, category.class_weights, right_weights);
+        
+        evaluated++;
+        if (gain > best_gain) {
+            best_gain = gain;
+            best_value = split_val;
+        }
+    }
+    split_evaluations.add(evaluated);
+    
+    return {best_gain, best_value};
+}
+
+// Helper: Sum of squared deviations from the mean, from running sums
+static double squared_error(double sum, double sum_squares, double count) {
+    return count > 0 ? max(sum_squares - sum * sum / count, 0.0) : 0.0;
+}
+
+decision_tree::numeric_split decision_tree::find_best_numerical_regression_split(
+    const data_frame& df,
+    const vector<size_t>& indices,
+    int feature_idx,
+    const vector<double>& targets,
+    const vector<double>& weights
+) {
+    const col* feature_col = df.get_column(feature_names[feature_idx]);
+    
+    // Collect (feature value, target, weight); rows missing the feature only enter the sums
+    vector<tuple<double, double, double>> values_and_targets;
+    double missing_n = 0.0, missing_sum = 0.0, missing_squares = 0.0;
+    {
+        PRF_PROFILE_SCOPE(SORT);
+        values_and_targets.reserve(indices.size());
         for (size_t i = 0; i < indices.size(); ++i) {
-            size_t idx = indices[i];
-            if (data[idx] == split_val) {
-                left_labels.push_back(encoded_labels[i]);
+            double value;
+            if (read_numeric(feature_col, indices[i], value)) {
+                values_and_targets.emplace_back(value, targets[i], weights[i]);
             } else {
-                right_labels.push_back(encoded_labels[i]);
+                missing_n += weights[i];
+                missing_sum += weights[i] * targets[i];
+                missing_squares += weights[i] * targets[i] * targets[i];
             }
         }
         
-        // Skip if split doesn't divide
-        if (left_labels.empty() || right_labels.empty()) continue;
+        sort(values_and_targets.begin(), values_and_targets.end());
+    }
+    
+    PRF_PROFILE_SCOPE(SPLIT_SCORING);
+    
+    // Weighted count / sum / sum of squares of the rows with a value
+    double present_n = 0.0, present_sum = 0.0, present_squares = 0.0;
+    for (const auto& [value, target, weight] : values_and_targets) {
+        present_n += weight;
+        present_sum += weight * target;
+        present_squares += weight * target * target;
+    }
+    double n = present_n + missing_n;
+    double parent_error = squared_error(present_sum + missing_sum, present_squares + missing_squares, n);
+    
+    numeric_split best = {-numeric_limits<double>::infinity(), 0.0, false};
+    if (n <= 0.0) return best;
+    
+    // Sweep split points left to right, moving one row at a time into the left side
+    double left_n = 0.0, left_sum = 0.0, left_squares = 0.0;
+    uint64_t evaluated = 0;
+    for (size_t i = 0; i + 1 < values_and_targets.size(); ++i) {
+        const auto& [value, target, weight] = values_and_targets[i];
+        left_n += weight;
+        left_sum += weight * target;
+        left_squares += weight * target * target;
         
-        // Calculate gain
-        double gain = 0.0;
-        if (growing_config && growing_config->criterion == tree_growing_config::SplitCriterion::GINI) {
-            gain = metrics::gini_gain(parent_labels, left_labels, right_labels, num_classes);
-        } else { // SHANNON_ENTROPY or no config
-            gain = metrics::entropy_gain(parent_labels, left_labels, right_labels, num_classes);
+        // Skip if same value
+        double next_value = get<0>(values_and_targets[i + 1]);
+        if (value == next_value) {
+            continue;
         }
         
+        double right_n = present_n - left_n;
+        double right_sum = present_sum - left_sum, right_squares = present_squares - left_squares;
+        
+        // Missing rows join the left, then the right side
+        double error_missing_left = squared_error(left_sum + missing_sum, left_squares + missing_squares, left_n + missing_n) +
+                                    squared_error(right_sum, right_squares, right_n);
+        double error_missing_right = squared_error(left_sum, left_squares, left_n) +
+                                     squared_error(right_sum + missing_sum, right_squares + missing_squares, right_n + missing_n);
+        bool missing_left = missing_n > 0 ? error_missing_left <= error_missing_right : left_n >= right_n;
+        double gain = (parent_error - min(error_missing_left, error_missing_right)) / n;
+        
+        evaluated++;
+        if (gain > best.gain) {
+            best = {gain, (value + next_value) / 2.0, missing_left};
+        }
+    }
+    split_evaluations.add(evaluated);
+    
+    return best;
+}
+
+pair<double, string> decision_tree::find_best_categorical_regression_split(
+    const data_frame& df,
+    const vector<size_t>& indices,
+    int feature_idx,
+    const vector<double>& targets,
+    const vector<double>& weights
+) {
+    const auto& data = df.get_string_column(feature_names[feature_idx])->get_data();
+    PRF_PROFILE_SCOPE(SPLIT_SCORING);
+    
+    // Per category: rows, weighted count, sum, sum of squares
+    struct category_sums {
+        size_t rows = 0;
+        double count = 0.0, sum = 0.0, squares = 0.0;
+    };
+    map<string, category_sums> categories;
+    double n = 0.0, total_sum = 0.0, total_squares = 0.0;
+    for (size_t i = 0; i < indices.size(); ++i) {
+        category_sums& sums = categories[data[indices[i]]];
+        double weighted_target = weights[i] * targets[i];
+        sums.rows++;
+        sums.count += weights[i];
+        sums.sum += weighted_target;
+        sums.squares += weighted_target * targets[i];
+        n += weights[i];
+        total_sum += weighted_target;
+        total_squares += weighted_target * targets[i];
+    }
+    
+    double parent_error = squared_error(total_sum, total_squares, n);
+    double best_gain = -numeric_limits<double>::infinity();
+    string best_value;
+    if (n <= 0.0) return {best_gain, best_value};
+    
+    // Try each unique value as split (one-vs-rest)
+    uint64_t evaluated = 0;
+    for (const auto& [split_val, sums] : categories) {
+        // Skip if split doesn't divide
+        if (sums.rows == indices.size()) continue;
+        
+        double children_error = squared_error(sums.sum, sums.squares, sums.count) +
+                                squared_error(total_sum - sums.sum, total_squares - sums.squares, n - sums.count);
+        double gain = (parent_error - children_error) / n;
+        
+        evaluated++;
         if (gain > best_gain) {
             best_gain = gain;
             best_value = split_val;
         }
     }
+    split_evaluations.add(evaluated);
     
     return {best_gain, best_value};
 }
@@ -451,12 +804,7 @@ int decision_tree::predict_single(
         go_left = (str_col->get(row_idx) == node->split_value);
     } else {
         double value = 0.0;
-        if (auto int_col_ptr = dynamic_cast<const int_col*>(feature_col)) {
-            value = static_cast<double>(int_col_ptr->get(row_idx));
-        } else if (auto float_col_ptr = dynamic_cast<const float_col*>(feature_col)) {
-            value = float_col_ptr->get(row_idx);
-        }
-        go_left = (value <= node->threshold);
+        go_left = read_numeric(feature_col, row_idx, value) ? (value <= node->threshold) : node->missing_left;
     }
     
     return predict_single(go_left ? node->left.get() : node->right.get(), X, row_idx);
@@ -481,12 +829,7 @@ vector<double> decision_tree::predict_proba_single(
         go_left = (str_col->get(row_idx) == node->split_value);
     } else {
         double value = 0.0;
-        if (auto int_col_ptr = dynamic_cast<const int_col*>(feature_col)) {
-            value = static_cast<double>(int_col_ptr->get(row_idx));
-        } else if (auto float_col_ptr = dynamic_cast<const float_col*>(feature_col)) {
-            value = float_col_ptr->get(row_idx);
-        }
-        go_left = (value <= node->threshold);
+        go_left = read_numeric(feature_col, row_idx, value) ? (value <= node->threshold) : node->missing_left;
     }
     
     return predict_proba_single(go_left ? node->left.get() : node->right.get(), X, row_idx);
@@ -504,6 +847,19 @@ vector<int> decision_tree::predict(const data_frame& X) const {
     return predictions;
 }
 
+vector<int> decision_tree::predict(const data_frame& X, const vector<size_t>& row_indices) const {
+    if (!root) {
+        throw runtime_error("Tree not fitted. Call fit() first.");
+    }
+    
+    vector<int> predictions;
+    predictions.reserve(row_indices.size());
+    for (size_t idx : row_indices) {
+        predictions.push_back(predict_single(root.get(), X, idx));
+    }
+    return predictions;
+}
+
 vector<vector<double>> decision_tree::predict_proba(const data_frame& X) const {
     if (!root) {
         throw runtime_error("Tree not fitted. Call fit() first.");
@@ -515,3 +871,27 @@ vector<vector<double>> decision_tree::predict_proba(const data_frame& X) const {
     }
     return probabilities;
 }
+
+const vector<double>& decision_tree::get_feature_importances() const {
+    return feature_importances;
+}
+
+bool decision_tree::is_regressor() const {
+    return regression;
+}
+
+vector<double> decision_tree::predict_values(const data_frame& X) const {
+    if (!root) {
+        throw runtime_error("Tree not fitted. Call fit() first.");
+    }
+    if (!regression) {
+        throw runtime_error("predict_values needs a regression tree (float target); use predict");
+    }
+    
+    vector<double> values;
+    values.reserve(X.get_num_rows());
+    for (size_t i = 0; i < X.get_num_rows(); ++i) {
+        values.push_back(predict_proba_single(root.get(), X, i)[0]);
+    }
+    return values;
+}
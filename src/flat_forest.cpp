@@ -0,0 +1,575 @@
+/*
+Flattened forest for low-latency single-row inference
+*/
+
+#include "flat_forest.hpp"
+#include "binary_io.hpp"
+#include "metrics_registry.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+static metric_counter& rows_scored = metrics_registry::global().get_counter(
+    "prf_rows_scored_total", "Rows evaluated by a forest (predict and predict_proba each count)");
+
+void flat_forest::reset(int num_classes, const vector<vector<string>>& feature_categories) {
+    nodes.clear();
+    roots.clear();
+    leaf_probabilities.clear();
+    leaf_pool.clear();
+    heap_trees.clear();
+    heap_features.clear();
+    heap_thresholds.clear();
+    heap_missing_left.clear();
+    heap_leaves.clear();
+    heap_enabled = true;
+    this->num_classes = num_classes;
+    categories = feature_categories;
+}
+
+int flat_forest::append_node(const decision_tree::TreeNode* node) {
+    if (!node) {
+        throw runtime_error("Cannot flatten tree: missing child node");
+    }
+
+    int idx = nodes.size();
+    nodes.push_back(flat_node());
+
+    flat_node flat;
+    flat.feature_idx = -1;
+    flat.is_categorical = false;
+    flat.missing_left = false;
+    flat.threshold = 0.0;
+    flat.left = -1;
+    flat.right = -1;
+    flat.predicted_class = 0;
+    flat.leaf_offset = -1;
+
+    if (node->is_leaf) {
+        flat.predicted_class = node->predicted_class;
+
+        // Pad (or trim) to the forest's class count
+        vector<double> distribution(num_classes, 0.0);
+        for (int c = 0; c < num_classes && c < (int)node->class_probabilities.size(); ++c) {
+            distribution[c] = node->class_probabilities[c];
+        }
+        flat.leaf_offset = intern_leaf(distribution, node->predicted_class);
+    } else {
+        flat.feature_idx = node->feature_idx;
+        flat.is_categorical = node->is_categorical;
+
+        if (node->is_categorical) {
+            flat.threshold = encode_category(node->feature_idx, node->split_value);
+        } else {
+            flat.threshold = node->threshold;
+            flat.missing_left = node->missing_left;
+        }
+
+        flat.left = append_node(node->left.get());
+        flat.right = append_node(node->right.get());
+    }
+
+    nodes[idx] = flat;
+    return idx;
+}
+
+int flat_forest::intern_leaf(const vector<double>& distribution, int predicted_class) {
+    // Pure leaves (the common case) need nothing beyond their class id
+    bool one_hot = predicted_class >= 0 && predicted_class < num_classes;
+    for (int c = 0; c < num_classes && one_hot; ++c) {
+        one_hot = distribution[c] == (c == predicted_class ? 1.0 : 0.0);
+    }
+    if (one_hot) return -1;
+
+    auto it = leaf_pool.find(distribution);
+    if (it != leaf_pool.end()) return it->second;
+
+    int offset = leaf_probabilities.size();
+    leaf_probabilities.insert(leaf_probabilities.end(), distribution.begin(), distribution.end());
+    leaf_pool.emplace(distribution, offset);
+    return offset;
+}
+
+inline void flat_forest::add_leaf(const flat_node& leaf, double* proba) const {
+    if (leaf.leaf_offset < 0) {
+        proba[leaf.predicted_class] += 1.0;
+        return;
+    }
+
+    const double* probabilities = leaf_probabilities.data() + leaf.leaf_offset;
+    for (int c = 0; c < num_classes; ++c) {
+        proba[c] += probabilities[c];
+    }
+}
+
+void flat_forest::append_tree(const decision_tree& tree) {
+    if (!tree.root) {
+        throw runtime_error("Tree not fitted. Call fit() first.");
+    }
+    roots.push_back(append_node(tree.root.get()));
+    append_heap(roots.back());
+}
+
+int flat_forest::subtree_depth(int node_idx) const {
+    const flat_node& node = nodes[node_idx];
+    if (node.feature_idx < 0) return 0;
+    if (node.is_categorical) return -1;
+
+    int left = subtree_depth(node.left);
+    int right = subtree_depth(node.right);
+    if (left < 0 || right < 0) return -1;
+    return 1 + max(left, right);
+}
+
+void flat_forest::fill_heap(int node_idx, int slot, int level, const heap_tree& tree) {
+    if (level == tree.depth) {
+        heap_leaves[tree.leaf_offset + slot - ((1 << tree.depth) - 1)] = node_idx;
+        return;
+    }
+
+    const flat_node& node = nodes[node_idx];
+    int left = node_idx, right = node_idx;
+    if (node.feature_idx >= 0) {
+        heap_features[tree.split_offset + slot] = node.feature_idx;
+        heap_thresholds[tree.split_offset + slot] = node.threshold;
+        heap_missing_left[tree.split_offset + slot] = node.missing_left;
+        left = node.left;
+        right = node.right;
+    } else {
+        // Leaf above the bottom level: pass-through split, every row goes left
+        heap_features[tree.split_offset + slot] = 0;
+        heap_thresholds[tree.split_offset + slot] = numeric_limits<double>::infinity();
+        heap_missing_left[tree.split_offset + slot] = 1;
+    }
+
+    fill_heap(left, 2 * slot + 1, level + 1, tree);
+    fill_heap(right, 2 * slot + 2, level + 1, tree);
+}
+
+void flat_forest::append_heap(int root) {
+    if (!heap_enabled) return;
+
+    int depth = subtree_depth(root);
+    if (depth < 0 || depth > max_heap_depth) {
+        heap_enabled = false;
+        heap_trees.clear();
+        heap_features.clear();
+        heap_thresholds.clear();
+        heap_missing_left.clear();
+        heap_leaves.clear();
+        return;
+    }
+
+    heap_tree tree;
+    tree.depth = depth;
+    tree.split_offset = heap_features.size();
+    tree.leaf_offset = heap_leaves.size();
+    heap_features.resize(heap_features.size() + (1 << depth) - 1);
+    heap_thresholds.resize(heap_thresholds.size() + (1 << depth) - 1);
+    heap_missing_left.resize(heap_missing_left.size() + (1 << depth) - 1);
+    heap_leaves.resize(heap_leaves.size() + (1 << depth));
+
+    fill_heap(root, 0, 0, tree);
+    heap_trees.push_back(tree);
+}
+
+bool flat_forest::empty() const {
+    return roots.empty();
+}
+
+int flat_forest::get_num_trees() const {
+    return roots.size();
+}
+
+int flat_forest::get_num_classes() const {
+    return num_classes;
+}
+
+int flat_forest::get_num_features() const {
+    return categories.size();
+}
+
+size_t flat_forest::memory_bytes() const {
+    return nodes.size() * sizeof(flat_node) + roots.size() * sizeof(int) +
+           leaf_probabilities.size() * sizeof(double);
+}
+
+int flat_forest::get_num_pooled_leaves() const {
+    return num_classes > 0 ? leaf_probabilities.size() / num_classes : 0;
+}
+
+double flat_forest::encode_category(int feature_idx, const string& value) const {
+    if (feature_idx < 0 || feature_idx >= (int)categories.size()) {
+        throw out_of_range("Feature index out of range: " + to_string(feature_idx));
+    }
+
+    const vector<string>& values = categories[feature_idx];
+    auto it = lower_bound(values.begin(), values.end(), value);
+    if (it == values.end() || *it != value) return -1.0;
+    return it - values.begin();
+}
+
+void flat_forest::write(ostream& out) const {
+    write_pod(out, (int32_t)num_classes);
+
+    write_pod(out, (uint32_t)categories.size());
+    for (const auto& values : categories) {
+        write_pod(out, (uint32_t)values.size());
+        for (const auto& value : values) write_string(out, value);
+    }
+
+    write_pod(out, (uint32_t)roots.size());
+    for (int root : roots) write_pod(out, (int32_t)root);
+
+    write_pod(out, (uint64_t)nodes.size());
+    for (const auto& node : nodes) {
+        write_pod(out, (int32_t)node.feature_idx);
+        write_pod(out, (uint8_t)(node.is_categorical | node.missing_left << 1));
+        write_pod(out, node.threshold);
+        write_pod(out, (int32_t)node.left);
+        write_pod(out, (int32_t)node.right);
+        write_pod(out, (int32_t)node.predicted_class);
+        write_pod(out, (int32_t)node.leaf_offset);
+    }
+
+    write_pod(out, (uint64_t)leaf_probabilities.size());
+    out.write(reinterpret_cast<const char*>(leaf_probabilities.data()), leaf_probabilities.size() * sizeof(double));
+}
+
+void flat_forest::read(istream& in) {
+    num_classes = read_pod<int32_t>(in);
+
+    categories.assign(read_pod<uint32_t>(in), vector<string>());
+    for (auto& values : categories) {
+        values.resize(read_pod<uint32_t>(in));
+        for (auto& value : values) value = read_string(in);
+    }
+
+    roots.resize(read_pod<uint32_t>(in));
+    for (int& root : roots) root = read_pod<int32_t>(in);
+
+    nodes.resize(read_pod<uint64_t>(in));
+    for (auto& node : nodes) {
+        node.feature_idx = read_pod<int32_t>(in);
+        uint8_t flags = read_pod<uint8_t>(in);
+        node.is_categorical = flags & 1;
+        node.missing_left = flags & 2;
+        node.threshold = read_pod<double>(in);
+        node.left = read_pod<int32_t>(in);
+        node.right = read_pod<int32_t>(in);
+        node.predicted_class = read_pod<int32_t>(in);
+        node.leaf_offset = read_pod<int32_t>(in);
+    }
+
+    leaf_probabilities.resize(read_pod<uint64_t>(in));
+    if (!in.read(reinterpret_cast<char*>(leaf_probabilities.data()), leaf_probabilities.size() * sizeof(double))) {
+        throw runtime_error("Unexpected end of binary file");
+    }
+
+    // Reject indices that would walk outside the arrays
+    for (int root : roots) {
+        if (root < 0 || root >= (int)nodes.size()) throw runtime_error("Corrupt model: bad root index");
+    }
+    for (const auto& node : nodes) {
+        if (node.feature_idx >= (int)categories.size()) {
+            throw runtime_error("Corrupt model: bad feature index");
+        }
+        if (node.feature_idx >= 0) {
+            if (node.left < 0 || node.left >= (int)nodes.size() || node.right < 0 || node.right >= (int)nodes.size()) {
+                throw runtime_error("Corrupt model: bad child index");
+            }
+        } else if (node.predicted_class < 0 || node.predicted_class >= num_classes ||
+                   node.leaf_offset < -1 ||
+                   (node.leaf_offset >= 0 && node.leaf_offset + num_classes > (int)leaf_probabilities.size())) {
+            throw runtime_error("Corrupt model: bad leaf");
+        }
+    }
+
+    // Children always follow their parent in preorder, which also rules out cycles
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (nodes[i].feature_idx >= 0 && (nodes[i].left <= (int)i || nodes[i].right <= (int)i)) {
+            throw runtime_error("Corrupt model: bad child index");
+        }
+    }
+
+    leaf_pool.clear();
+    for (size_t offset = 0; offset + num_classes <= leaf_probabilities.size(); offset += num_classes) {
+        vector<double> distribution(leaf_probabilities.begin() + offset, leaf_probabilities.begin() + offset + num_classes);
+        leaf_pool.emplace(distribution, offset);
+    }
+
+    heap_trees.clear();
+    heap_features.clear();
+    heap_thresholds.clear();
+    heap_missing_left.clear();
+    heap_leaves.clear();
+    heap_enabled = true;
+    for (int root : roots) append_heap(root);
+}
+
+bool flat_forest::uses_heap_layout() const {
+    return heap_enabled && !heap_trees.empty();
+}
+
+void flat_forest::predict_rows(const double* rows, size_t n_rows, size_t n_features,
+                               int* classes_out, double* proba_out) const {
+    if (!uses_heap_layout()) {
+        for (size_t r = 0; r < n_rows; ++r) {
+            classes_out[r] = predict_row(rows + r * n_features, proba_out + r * num_classes);
+        }
+        return;
+    }
+    rows_scored.add(n_rows);
+
+    // Rows per block: every tree level advances all of them in one vectorizable loop
+    const int block = 16;
+    thread_local vector<int> votes;
+    votes.assign((size_t)block * num_classes, 0);
+
+    for (size_t start = 0; start < n_rows; start += block) {
+        int count = (int)min<size_t>(block, n_rows - start);
+        const double* block_rows = rows + start * n_features;
+        double* block_proba = proba_out + start * num_classes;
+        fill(block_proba, block_proba + (size_t)count * num_classes, 0.0);
+        fill(votes.begin(), votes.end(), 0);
+
+        for (const heap_tree& tree : heap_trees) {
+            const int* features = heap_features.data() + tree.split_offset;
+            const double* thresholds = heap_thresholds.data() + tree.split_offset;
+            const uint8_t* missing_left = heap_missing_left.data() + tree.split_offset;
+
+            int slot[block] = {0};
+            for (int level = 0; level < tree.depth; ++level) {
+                #pragma omp simd
+                for (int r = 0; r < block; ++r) {
+                    // Rows past count read row 0 of the block; their result is discarded
+                    int row = r < count ? r : 0;
+                    double value = block_rows[row * n_features + features[slot[r]]];
+                    bool go_left = (value <= thresholds[slot[r]]) | ((value != value) & (missing_left[slot[r]] != 0));
+                    slot[r] = 2 * slot[r] + 1 + !go_left;
+                }
+            }
+
+            int first_leaf = (1 << tree.depth) - 1;
+            for (int r = 0; r < count; ++r) {
+                const flat_node& leaf = nodes[heap_leaves[tree.leaf_offset + slot[r] - first_leaf]];
+                votes[r * num_classes + leaf.predicted_class]++;
+                add_leaf(leaf, block_proba + r * num_classes);
+            }
+        }
+
+        double num_trees = heap_trees.size();
+        for (int r = 0; r < count; ++r) {
+            for (int c = 0; c < num_classes; ++c) {
+                block_proba[r * num_classes + c] /= num_trees;
+            }
+            auto row_votes = votes.begin() + r * num_classes;
+            classes_out[start + r] = max_element(row_votes, row_votes + num_classes) - row_votes;
+        }
+    }
+}
+
+// ==================== C++ Code Generation ====================
+
+// Round-trip exact double literal
+static string cpp_double(double value) {
+    if (std::isnan(value)) return "NAN";
+    if (std::isinf(value)) return value > 0 ? "HUGE_VAL" : "-HUGE_VAL";
+    ostringstream literal;
+    literal << setprecision(17) << value;
+    string text = literal.str();
+    if (text.find_first_of(".eE") == string::npos) text += ".0";
+    return text;
+}
+
+static string cpp_string(const string& value) {
+    ostringstream literal;
+    literal << '"';
+    for (unsigned char ch : value) {
+        if (ch == '"' || ch == '\\') {
+            literal << '\\' << ch;
+        } else if (ch < 0x20 || ch >= 0x7f) {
+            literal << '\\' << oct << setw(3) << setfill('0') << (int)ch << dec << setfill(' ');
+        } else {
+            literal << ch;
+        }
+    }
+    literal << '"';
+    return literal.str();
+}
+
+void flat_forest::write_cpp_node(ostream& out, int node_idx, int indent) const {
+    const flat_node& node = nodes[node_idx];
+    string pad(indent * 4, ' ');
+
+    if (node.feature_idx < 0) {
+        if (node.leaf_offset < 0) {
+            out << pad << "p[" << node.predicted_class << "] += 1.0;\n";
+        } else {
+            const double* probabilities = leaf_probabilities.data() + node.leaf_offset;
+            for (int c = 0; c < num_classes; ++c) {
+                if (probabilities[c] != 0.0) {
+                    out << pad << "p[" << c << "] += " << cpp_double(probabilities[c]) << ";\n";
+                }
+            }
+        }
+        out << pad << "return " << node.predicted_class << ";\n";
+        return;
+    }
+
+    out << pad << "if (x[" << node.feature_idx << "] " << (node.is_categorical ? "==" : "<=") << " "
+        << cpp_double(node.threshold);
+    if (node.missing_left) {
+        out << " || isnan(x[" << node.feature_idx << "])";
+    }
+    out << ") {\n";
+    write_cpp_node(out, node.left, indent + 1);
+    out << pad << "} else {\n";
+    write_cpp_node(out, node.right, indent + 1);
+    out << pad << "}\n";
+}
+
+void flat_forest::export_cpp(ostream& out, const string& name,
+                             const vector<string>& feature_names,
+                             const vector<string>& class_labels) const {
+    if (empty()) {
+        throw runtime_error("Forest not fitted. Call fit() first.");
+    }
+    bool valid_name = !name.empty() && !isdigit((unsigned char)name[0]) &&
+        all_of(name.begin(), name.end(), [](unsigned char ch) { return isalnum(ch) || ch == '_'; });
+    if (!valid_name) {
+        throw invalid_argument("Not a valid C identifier: '" + name + "'");
+    }
+    if (feature_names.size() != categories.size() || (int)class_labels.size() != num_classes) {
+        throw invalid_argument("Feature names / class labels do not match the flattened forest");
+    }
+
+    string guard = name;
+    transform(guard.begin(), guard.end(), guard.begin(), [](unsigned char ch) { return toupper(ch); });
+    guard += "_SCORER_HPP";
+
+    out << "// Generated random forest scorer: " << roots.size() << " trees, "
+        << feature_names.size() << " features, " << num_classes << " classes. Do not edit.\n"
+        << "//\n"
+        << "// Header-only: include it and call " << name << "_predict().\n"
+        << "// Shared object: g++ -O2 -shared -fPIC -x c++ -DPRF_SCORER_EXPORT= " << name << ".hpp -o lib" << name << ".so\n"
+        << "//\n"
+        << "// Rows are dense doubles in feature order; categorical features hold the\n"
+        << "// code returned by " << name << "_encode_category() (-1 if unseen).\n"
+        << "// Missing values are NAN.\n"
+        << "// Features:";
+    for (size_t f = 0; f < feature_names.size(); ++f) {
+        out << (f > 0 ? "," : "") << " " << f << "=" << feature_names[f];
+    }
+    out << "\n\n"
+        << "#ifndef " << guard << "\n"
+        << "#define " << guard << "\n\n"
+        << "#include <math.h>\n"
+        << "#include <string.h>\n\n"
+        << "#ifndef PRF_SCORER_EXPORT\n"
+        << "#define PRF_SCORER_EXPORT inline\n"
+        << "#endif\n\n";
+
+    // One function per tree: adds the leaf distribution to p, returns the leaf class
+    for (size_t t = 0; t < roots.size(); ++t) {
+        out << "static inline int " << name << "_tree_" << t << "(const double* x, double* p) {\n";
+        write_cpp_node(out, roots[t], 1);
+        out << "}\n\n";
+    }
+
+    out << "extern \"C\" {\n\n";
+
+    out << "PRF_SCORER_EXPORT int " << name << "_num_features(void) { return " << feature_names.size() << "; }\n"
+        << "PRF_SCORER_EXPORT int " << name << "_num_classes(void) { return " << num_classes << "; }\n"
+        << "PRF_SCORER_EXPORT int " << name << "_num_trees(void) { return " << roots.size() << "; }\n\n";
+
+    out << "PRF_SCORER_EXPORT const char* " << name << "_feature_name(int feature_idx) {\n"
+        << "    static const char* const names[] = {";
+    for (size_t f = 0; f < feature_names.size(); ++f) {
+        out << (f > 0 ? ", " : "") << cpp_string(feature_names[f]);
+    }
+    out << "};\n"
+        << "    return feature_idx >= 0 && feature_idx < " << feature_names.size() << " ? names[feature_idx] : 0;\n"
+        << "}\n\n";
+
+    out << "PRF_SCORER_EXPORT const char* " << name << "_class_label(int class_idx) {\n"
+        << "    static const char* const labels[] = {";
+    for (int c = 0; c < num_classes; ++c) {
+        out << (c > 0 ? ", " : "") << cpp_string(class_labels[c]);
+    }
+    out << "};\n"
+        << "    return class_idx >= 0 && class_idx < " << num_classes << " ? labels[class_idx] : 0;\n"
+        << "}\n\n";
+
+    out << "PRF_SCORER_EXPORT double " << name << "_encode_category(int feature_idx, const char* value) {\n"
+        << "    switch (feature_idx) {\n";
+    for (size_t f = 0; f < categories.size(); ++f) {
+        if (categories[f].empty()) continue;
+        out << "    case " << f << ":\n";
+        for (size_t code = 0; code < categories[f].size(); ++code) {
+            out << "        if (strcmp(value, " << cpp_string(categories[f][code]) << ") == 0) return " << code << ";\n";
+        }
+        out << "        break;\n";
+    }
+    out << "    }\n"
+        << "    return -1;\n"
+        << "}\n\n";
+
+    // Same vote/average order as flat_forest::predict_row, so results are identical
+    out << "// proba_out receives " << num_classes << " averaged probabilities; returns the majority-vote class\n"
+        << "PRF_SCORER_EXPORT int " << name << "_predict(const double* row, double* proba_out) {\n"
+        << "    int votes[" << num_classes << "] = {0};\n"
+        << "    for (int c = 0; c < " << num_classes << "; ++c) proba_out[c] = 0.0;\n";
+    for (size_t t = 0; t < roots.size(); ++t) {
+        out << "    votes[" << name << "_tree_" << t << "(row, proba_out)]++;\n";
+    }
+    out << "    const double num_trees = " << roots.size() << ".0;\n"
+        << "    int best = 0;\n"
+        << "    for (int c = 0; c < " << num_classes << "; ++c) {\n"
+        << "        proba_out[c] /= num_trees;\n"
+        << "        if (votes[c] > votes[best]) best = c;\n"
+        << "    }\n"
+        << "    return best;\n"
+        << "}\n\n"
+        << "} // extern \"C\"\n\n"
+        << "#endif // " << guard << "\n";
+}
+
+int flat_forest::predict_row(const double* row, double* proba_out) const {
+    rows_scored.add();
+
+    // Per-thread vote buffer: sized once, reused by every later call
+    thread_local vector<int> votes;
+    votes.assign(num_classes, 0);
+    fill(proba_out, proba_out + num_classes, 0.0);
+
+    const flat_node* base = nodes.data();
+    for (int root : roots) {
+        const flat_node* node = base + root;
+        while (node->feature_idx >= 0) {
+            double value = row[node->feature_idx];
+            bool go_left = node->is_categorical ? (value == node->threshold)
+                         : std::isnan(value) ? node->missing_left : (value <= node->threshold);
+            node = base + (go_left ? node->left : node->right);
+        }
+
+        votes[node->predicted_class]++;
+        add_leaf(*node, proba_out);
+    }
+
+    // Divide (not scale) so results match decision_tree::predict_proba averaged per tree
+    if (!roots.empty()) {
+        double num_trees = roots.size();
+        for (int c = 0; c < num_classes; ++c) {
+            proba_out[c] /= num_trees;
+        }
+    }
+
+    return max_element(votes.begin(), votes.end()) - votes.begin();
+}
@@ -0,0 +1,230 @@
+/*
+Parallel grid search with k-fold cross-validation and successive halving
+*/
+
+#include "grid_search.hpp"
+#include "cross_validation.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <omp.h>
+
+using namespace std;
+
+// Helper: Tree budget of a candidate at a given rung
+static int rung_budget(const search_candidate& candidate, int rung, const grid_search_config& config) {
+    if (!config.use_successive_halving) {
+        return candidate.forest.num_trees;
+    }
+
+    double budget = config.min_trees * pow(config.halving_factor, rung);
+    return (int)min<double>(candidate.forest.num_trees, max(1.0, budget));
+}
+
+string search_candidate::describe() const {
+    ostringstream out;
+    out << "depth=" << hp.max_depth
+        << " min_leaf=" << hp.min_examples_per_leaf
+        << " criterion=" << (growing.criterion == tree_growing_config::SplitCriterion::GINI ? "gini" : "entropy")
+        << " trees=" << forest.num_trees
+        << " bootstrap=" << forest.bootstrap_sample_ratio;
+    return out.str();
+}
+
+vector<search_candidate> grid_search::enumerate(const search_space& space) {
+    vector<search_candidate> candidates;
+
+    for (int depth : space.max_depth)
+    for (int min_leaf : space.min_examples_per_leaf)
+    for (auto criterion : space.criterion)
+    for (int num_trees : space.num_trees)
+    for (double ratio : space.bootstrap_sample_ratio) {
+        search_candidate candidate;
+        candidate.growing = space.base_growing;
+        candidate.forest = space.base_forest;
+        candidate.hp.max_depth = depth;
+        candidate.hp.min_examples_per_leaf = min_leaf;
+        candidate.growing.criterion = criterion;
+        candidate.forest.num_trees = num_trees;
+        candidate.forest.bootstrap_sample_ratio = ratio;
+        candidates.push_back(candidate);
+    }
+
+    return candidates;
+}
+
+vector<search_result> grid_search::run(
+    const data_frame& df,
+    const vector<string>& feature_cols,
+    const string& target_col,
+    const search_space& space
+) {
+    if (!search_config) {
+        throw runtime_error("grid_search_config not set. Set search_config before calling run().");
+    }
+    if (search_config->halving_factor < 2) {
+        throw invalid_argument("halving_factor must be at least 2");
+    }
+
+    // Encode the target once, before any job runs (fit_encoding is not thread-safe)
+    vector<int> labels = encoded_targets(df, target_col);
+
+    // Build candidate list (full grid or random subset of it)
+    vector<search_candidate> candidates = enumerate(space);
+    if (search_config->num_random_candidates > 0 &&
+        search_config->num_random_candidates < (int)candidates.size()) {
+        mt19937 rng(search_config->random_seed);
+        shuffle(candidates.begin(), candidates.end(), rng);
+        candidates.resize(search_config->num_random_candidates);
+    }
+
+    // Build folds as index views over the rows of df that have a target
+    int k = search_config->num_folds;
+    vector<kfold_split> splits = make_kfold_splits(df.present_rows(target_col), k, search_config->fold_seed);
+
+    // Per-candidate configs and per-(candidate, fold) forests live across rungs,
+    // so survivors only train the trees they are missing
+    vector<tree_hyperparameters> hps(candidates.size());
+    vector<tree_growing_config> growings(candidates.size());
+    vector<random_forest_config> forest_configs(candidates.size());
+    vector<vector<random_forest>> forests(candidates.size());
+    for (size_t c = 0; c < candidates.size(); ++c) {
+        hps[c] = candidates[c].hp;
+        growings[c] = candidates[c].growing;
+        forest_configs[c] = candidates[c].forest;
+        growings[c].use_parallel = false;
+        forest_configs[c].use_parallel = false;
+
+        forests[c].resize(k);
+        for (auto& forest : forests[c]) {
+            forest.hp_config = &hps[c];
+            forest.growing_config = &growings[c];
+            forest.rf_config = &forest_configs[c];
+        }
+    }
+
+    vector<search_result> latest(candidates.size());
+    vector<int> alive(candidates.size());
+    iota(alive.begin(), alive.end(), 0);
+
+    for (int rung = 0; !alive.empty(); ++rung) {
+        // Candidates whose budget did not grow keep their previous score; a lone
+        // survivor cannot be eliminated any more, so it goes straight to its full budget
+        vector<int> to_train;
+        for (int c : alive) {
+            int budget = alive.size() == 1 ? candidates[c].forest.num_trees : rung_budget(candidates[c], rung, *search_config);
+            if (rung == 0 || budget != latest[c].trees_trained) {
+                to_train.push_back(c);
+                forest_configs[c].num_trees = budget;
+            }
+        }
+
+        vector<vector<double>> fold_accuracies(to_train.size(), vector<double>(k, 0.0));
+        vector<vector<double>> fold_times(to_train.size(), vector<double>(k, 0.0));
+        vector<int> folds_remaining(to_train.size(), k);
+        int num_jobs = to_train.size() * k;
+
+        // One job per (candidate, fold); each job trains serially, the pool parallelizes jobs.
+        // Exceptions cannot leave the parallel region, so each job records its own
+        vector<exception_ptr> job_errors(num_jobs);
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (int job = 0; job < num_jobs; ++job) {
+            try {
+                int slot = job / k;
+                int fold = job % k;
+                int c = to_train[slot];
+
+                // Warm start: grow the forest kept from the previous rung up to this rung's budget
+                random_forest& forest = forests[c][fold];
+                int new_trees = forest_configs[c].num_trees - forest.get_num_trees();
+
+                auto time_start = chrono::high_resolution_clock::now();
+                if (forest.get_num_trees() == 0) {
+                    forest.fit(df, feature_cols, target_col, &splits[fold].train_indices);
+                } else {
+                    forest.add_trees(df, new_trees, &splits[fold].train_indices);
+                }
+                auto time_end = chrono::high_resolution_clock::now();
+
+                vector<int> predictions = forest.predict(df, splits[fold].test_indices);
+                vector<int> truth;
+                truth.reserve(splits[fold].test_indices.size());
+                for (size_t idx : splits[fold].test_indices) {
+                    truth.push_back(labels[idx]);
+                }
+
+                fold_accuracies[slot][fold] = metrics::accuracy(predictions, truth);
+                fold_times[slot][fold] = chrono::duration<double, milli>(time_end - time_start).count();
+
+                int remaining;
+                #pragma omp atomic capture
+                remaining = --folds_remaining[slot];
+
+                // Last fold of this candidate: publish its result
+                if (remaining == 0) {
+                    search_result result;
+                    result.candidate_idx = c;
+                    result.candidate = candidates[c];
+                    result.rung = rung;
+                    result.trees_trained = forest_configs[c].num_trees;
+                    result.fold_accuracies = fold_accuracies[slot];
+                    result.mean_accuracy = accumulate(result.fold_accuracies.begin(), result.fold_accuracies.end(), 0.0) / k;
+
+                    double variance = 0.0;
+                    for (double acc : result.fold_accuracies) {
+                        variance += (acc - result.mean_accuracy) * (acc - result.mean_accuracy);
+                    }
+                    result.stddev_accuracy = sqrt(variance / k);
+                    result.train_time_ms = accumulate(fold_times[slot].begin(), fold_times[slot].end(), 0.0);
+                    result.eliminated = false;
+
+                    #pragma omp critical(grid_search_results)
+                    {
+                        latest[c] = result;
+                        if (on_result) on_result(result);
+                    }
+                }
+            } catch (...) {
+                job_errors[job] = current_exception();
+            }
+        }
+
+        for (const exception_ptr& error : job_errors) {
+            if (error) rethrow_exception(error);
+        }
+
+        if (!search_config->use_successive_halving) break;
+
+        // Stop once every survivor has been trained with its full budget
+        bool all_full = true;
+        for (int c : alive) {
+            if (latest[c].trees_trained < candidates[c].forest.num_trees) all_full = false;
+        }
+        if (all_full) break;
+
+        // Keep the best 1/eta of the survivors
+        sort(alive.begin(), alive.end(), [&](int a, int b) {
+            return latest[a].mean_accuracy > latest[b].mean_accuracy;
+        });
+        size_t keep = max<size_t>(1, alive.size() / search_config->halving_factor);
+        for (size_t i = keep; i < alive.size(); ++i) {
+            latest[alive[i]].eliminated = true;
+            forests[alive[i]].clear();
+        }
+        alive.resize(keep);
+    }
+
+    // Survivors first (best to worst), then eliminated candidates by score
+    sort(latest.begin(), latest.end(), [](const search_result& a, const search_result& b) {
+        if (a.eliminated != b.eliminated) return !a.eliminated;
+        if (a.trees_trained != b.trees_trained) return a.trees_trained > b.trees_trained;
+        return a.mean_accuracy > b.mean_accuracy;
+    });
+
+    return latest;
+}
@@ -11,6 +11,8 @@ Handles simple loading CSVs for dataset
 #include <stdexcept>
 #include <cctype>
 #include <set>
+#include <limits>
+#include <cmath>
 
 using namespace std;
 
@@ -45,6 +47,17 @@ void string_col::fit_encoding() const {
     encoding_fitted = true;
 }
 
+void string_col::set_encoding(const vector<string>& categories) const {
+    idx_to_value = categories;
+    value_to_idx.clear();
+    
+    for (size_t idx = 0; idx < categories.size(); ++idx) {
+        value_to_idx[categories[idx]] = idx;
+    }
+    
+    encoding_fitted = true;
+}
+
 int string_col::encode(const string& value) const {
     if (!encoding_fitted) {
         throw runtime_error("Encoding not fitted. Call fit_encoding() first.");
@@ -98,9 +111,36 @@ string string_col::get_type() const {
     return "string";
 }
 
+// ==================== Validity Bitmap ====================
+
+validity_bitmap::validity_bitmap(const vector<bool>& missing) {
+    for (bool m : missing) num_missing += m;
+    if (num_missing == 0) return;
+    
+    words.assign((missing.size() + 63) / 64, 0);
+    for (size_t i = 0; i < missing.size(); ++i) {
+        if (!missing[i]) words[i >> 6] |= uint64_t(1) << (i & 63);
+    }
+}
+
+validity_bitmap validity_bitmap::select(const vector<size_t>& indices) const {
+    if (words.empty()) return validity_bitmap();
+    
+    vector<bool> missing(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i) {
+        missing[i] = !is_valid(indices[i]);
+    }
+    return validity_bitmap(missing);
+}
+
+bool is_missing_value(const string& field) {
+    return field.empty() || field == "NA" || field == "N/A" || field == "NaN" || field == "nan" ||
+           field == "null" || field == "NULL" || field == "?";
+}
+
 // ==================== Integer Column Implementation ====================
 
-int_col::int_col(const vector<int>& values) : data(values) {}
+int_col::int_col(const vector<int>& values, validity_bitmap validity) : data(values), validity(move(validity)) {}
 
 int int_col::get(size_t index) const {
     if (index >= data.size()) {
@@ -114,7 +154,7 @@ const vector<int>& int_col::get_data() const {
 }
 
 unique_ptr<col> int_col::clone() const {
-    return make_unique<int_col>(data);
+    return make_unique<int_col>(data, validity);
 }
 
 size_t int_col::size() const {
@@ -127,7 +167,13 @@ string int_col::get_type() const {
 
 // ==================== Float Column Implementation ====================
 
-float_col::float_col(const vector<double>& values) : data(values) {}
+float_col::float_col(const vector<double>& values) : data(values) {
+    vector<bool> missing(data.size());
+    for (size_t i = 0; i < data.size(); ++i) {
+        missing[i] = std::isnan(data[i]);
+    }
+    validity = validity_bitmap(missing);
+}
 
 double float_col::get(size_t index) const {
     if (index >= data.size()) {
@@ -206,14 +252,14 @@ static bool is_float(const string& str) {
     return end != str.c_str() && *end == '\0';
 }
 
-static string infer_type(const vector<string>& values) {
+string infer_column_type(const vector<string>& values) {
     if (values.empty()) return "string";
     
     bool could_be_int = true;
     bool could_be_float = true;
     
     for (const auto& val : values) {
-        if (val.empty()) continue;
+        if (is_missing_value(val)) continue;
         
         if (could_be_int && !is_integer(val)) {
             could_be_int = false;
@@ -232,68 +278,93 @@ static string infer_type(const vector<string>& values) {
     return "string";
 }
 
-// ==================== Data Frame Implementation ====================
+// ==================== CSV Chunk Reader Implementation ====================
 
-data_frame data_frame::import_from(const string& path) {
-    ifstream file(path);
+csv_chunk_reader::csv_chunk_reader(const string& path) : file(path) {
     if (!file.is_open()) {
         throw runtime_error("Could not open file: " + path);
     }
     
-    data_frame df;
     string line;
-    
     if (!getline(file, line)) {
         throw runtime_error("Empty file or no header: " + path);
     }
     
-    vector<string> headers = parse_csv_line(line);
-    size_t num_cols = headers.size();
-    
-    vector<vector<string>> all_rows;
+    headers = parse_csv_line(line);
+}
+
+const vector<string>& csv_chunk_reader::get_headers() const {
+    return headers;
+}
+
+size_t csv_chunk_reader::read_chunk(vector<vector<string>>& rows, size_t max_rows) {
+    rows.clear();
+    string line;
     
-    while (getline(file, line)) {
+    while (rows.size() < max_rows && getline(file, line)) {
         if (line.empty()) continue;
         
         vector<string> row = parse_csv_line(line);
-        if (row.size() != num_cols) {
+        if (row.size() != headers.size()) {
             cerr << "Warning: Skipping row with " << row.size() 
-                      << " columns (expected " << num_cols << ")\n";
+                      << " columns (expected " << headers.size() << ")\n";
             continue;
         }
-        all_rows.push_back(row);
+        rows.push_back(move(row));
     }
     
-    file.close();
+    return rows.size();
+}
+
+// ==================== Data Frame Implementation ====================
+
+data_frame data_frame::import_from(const string& path) {
+    csv_chunk_reader reader(path);
+    
+    vector<vector<string>> all_rows;
+    reader.read_chunk(all_rows, numeric_limits<size_t>::max());
     
     if (all_rows.empty()) {
         cout << "Warning: No data rows found in file\n";
-        df.num_rows = 0;
-        return df;
+        return data_frame();
     }
     
-    df.num_rows = all_rows.size();
+    return from_rows(reader.get_headers(), all_rows);
+}
+
+data_frame data_frame::from_rows(
+    const vector<string>& headers,
+    const vector<vector<string>>& rows,
+    const vector<string>* column_types
+) {
+    data_frame df;
+    df.num_rows = rows.size();
     
-    for (size_t col_idx = 0; col_idx < num_cols; ++col_idx) {
+    for (size_t col_idx = 0; col_idx < headers.size(); ++col_idx) {
         vector<string> column_values;
-        for (const auto& row : all_rows) {
+        column_values.reserve(rows.size());
+        for (const auto& row : rows) {
             column_values.push_back(row[col_idx]);
         }
         
-        string col_type = infer_type(column_values);
+        string col_type = column_types ? (*column_types)[col_idx] : infer_column_type(column_values);
         
         if (col_type == "int") {
             vector<int> int_values;
-            for (const auto& val : column_values) {
-                int_values.push_back(val.empty() ? 0 : stoi(val));
+            vector<bool> missing(column_values.size(), false);
+            int_values.reserve(column_values.size());
+            for (size_t r = 0; r < column_values.size(); ++r) {
+                missing[r] = is_missing_value(column_values[r]);
+                int_values.push_back(missing[r] ? 0 : stoi(column_values[r]));
             }
             df.column_order.push_back(headers[col_idx]);
-            df.columns[headers[col_idx]] = make_unique<int_col>(int_values);
+            df.columns[headers[col_idx]] = make_unique<int_col>(int_values, validity_bitmap(missing));
             
         } else if (col_type == "float") {
             vector<double> float_values;
+            float_values.reserve(column_values.size());
             for (const auto& val : column_values) {
-                float_values.push_back(val.empty() ? 0.0 : stod(val));
+                float_values.push_back(is_missing_value(val) ? numeric_limits<double>::quiet_NaN() : stod(val));
             }
             df.column_order.push_back(headers[col_idx]);
             df.columns[headers[col_idx]] = make_unique<float_col>(float_values);
@@ -307,6 +378,19 @@ data_frame data_frame::import_from(const string& path) {
     return df;
 }
 
+void data_frame::add_column(const string& name, unique_ptr<col> column) {
+    if (!columns.empty() && column->size() != num_rows) {
+        throw invalid_argument("Column " + name + " has " + to_string(column->size()) +
+                               " rows (expected " + to_string(num_rows) + ")");
+    }
+    
+    if (columns.find(name) == columns.end()) {
+        column_order.push_back(name);
+    }
+    num_rows = column->size();
+    columns[name] = move(column);
+}
+
 const col* data_frame::get_column(const string& name) const {
     auto it = columns.find(name);
     if (it == columns.end()) {
@@ -388,6 +472,21 @@ pair<data_frame, data_frame> data_frame::train_test_split(double test_ratio, uns
     return make_pair(get_rows(train_indices), get_rows(test_indices));
 }
 
+vector<size_t> data_frame::present_rows(const string& column_name) const {
+    const col* column = get_column(column_name);
+    auto int_column = dynamic_cast<const int_col*>(column);
+    auto float_column = dynamic_cast<const float_col*>(column);
+    
+    vector<size_t> rows;
+    rows.reserve(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        if (int_column && int_column->is_missing(i)) continue;
+        if (float_column && float_column->is_missing(i)) continue;
+        rows.push_back(i);
+    }
+    return rows;
+}
+
 data_frame data_frame::get_rows(const vector<size_t>& indices) const {
     data_frame subset;
     subset.num_rows = indices.size();
@@ -418,7 +517,7 @@ data_frame data_frame::get_rows(const vector<size_t>& indices) const {
                 }
             }
             subset.column_order.push_back(col_name);
-            subset.columns[col_name] = make_unique<int_col>(values);
+            subset.columns[col_name] = make_unique<int_col>(values, i_col->get_validity().select(indices));
             
         } else if (auto f_col = dynamic_cast<const float_col*>(column)) {
             vector<double> values;
@@ -1,6 +1,12 @@
 #include <omp.h>
 #include <iostream>
 #include <string>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
 
 #include "loaders.hpp"         // Dataset handling
 #include "decision_tree.hpp"   // Decision tree
@@ -8,6 +14,12 @@
 #include "random_forest.hpp"   // Random forest
 #include "progress.hpp"        // Progress tracking
 #include "benchmark.hpp"       // Benchmark utilities
+#include "server.hpp"          // Scoring daemon and load generator
+#include "scoring.hpp"         // Streaming batch scorer
+#include "grid_search.hpp"     // Hyperparameter search
+#include "cross_validation.hpp" // Encoded targets
+#include "cli_options.hpp"     // Flags and config files
+#include "metrics_registry.hpp" // Prometheus metrics export
 
 using namespace std;
 
@@ -30,6 +42,7 @@ void menu() {
     cout << "\nChoose algorithm:" << endl;
     cout << "1. Random Forest" << endl;
     cout << "2. Decision Tree" << endl;
+    cout << "3. Grid Search (Random Forest hyperparameters)" << endl;
     cout << "Enter your choice: ";
     
     int testChoice;
@@ -39,6 +52,7 @@ void menu() {
     cout << "1. Diabetes (768 samples, 8 features, binary classification)" << endl;
     cout << "2. Palmer Penguins (344 samples, 5 features, 3 classes)" << endl;
     cout << "3. Dry Bean (13,611 samples, 16 features, 7 classes)" << endl;
+    cout << "4. Synthetic (generated in memory, configurable size)" << endl;
     cout << "Enter your choice: ";
     
     int datasetChoice;
@@ -46,6 +60,44 @@ void menu() {
 
     DatasetConfig dataset_config = get_dataset_config(datasetChoice);
 
+    if (datasetChoice == 4) {
+        synthetic_config synthetic;
+        cout << "\n--- Synthetic Dataset Configuration ---" << endl;
+        cout << "Enter the number of rows: ";
+        cin >> synthetic.num_rows;
+        cout << "Enter the number of numeric features: ";
+        cin >> synthetic.num_numeric_features;
+        cout << "Enter the number of categorical features: ";
+        cin >> synthetic.num_categorical_features;
+        cout << "Enter the number of classes: ";
+        cin >> synthetic.num_classes;
+        cout << "Enter the label noise (0-1): ";
+        cin >> synthetic.noise;
+        cout << "Enter the class imbalance (largest/smallest class, 1 = balanced): ";
+        cin >> synthetic.imbalance;
+        dataset_config = get_synthetic_dataset_config(synthetic);
+    }
+
+    if (testChoice == 3) {
+        // GRID SEARCH MODE
+        cout << "\n--- Grid Search Configuration ---" << endl;
+        cout << "Enter the maximum number of trees per candidate: ";
+        int maxTrees;
+        cin >> maxTrees;
+
+        if (maxTrees <= 0) {
+            cout << "Invalid number of trees! Using default: 27" << endl;
+            maxTrees = 27;
+        }
+
+        benchmark_grid_search(dataset_config, maxTrees);
+
+        cout << "\n========================================" << endl;
+        cout << "   Complete!" << endl;
+        cout << "========================================" << endl;
+        return;
+    }
+
     cout << "\nShow progress bar during training? (y/n): ";
     string showProgressStr;
     cin >> showProgressStr;
@@ -55,6 +107,9 @@ void menu() {
     cout << "1. Manual (configure parallelism options)" << endl;
     cout << "2. Benchmark (test all parallelism configurations)" << endl;
     cout << "3. Sample Size Benchmark (test different dataset sizes)" << endl;
+    cout << "4. Cross-Validation (k-fold, parallel folds)" << endl;
+    cout << "5. Repeated Benchmark (warmup, repetitions, variance, JSON/CSV output)" << endl;
+    cout << "6. Thread Scaling (strong and weak scaling over 1..N threads)" << endl;
     cout << "Enter your choice: ";
     
     int modeChoice;
@@ -145,9 +200,9 @@ void menu() {
                 numTrees = 50;
             }
 
-            // Only works with Dry Bean dataset
-            if (datasetChoice != 3) {
-                cout << "\nWarning: Sample size benchmark is designed for Dry Bean dataset (option 3)." << endl;
+            // Needs a data set larger than the biggest sample size
+            if (datasetChoice != 3 && datasetChoice != 4) {
+                cout << "\nWarning: Sample size benchmark is designed for the Dry Bean or a large synthetic dataset (option 3 or 4)." << endl;
                 cout << "Results may not be meaningful for other datasets." << endl;
             }
 
@@ -161,6 +216,107 @@ void menu() {
             exit(1);
         }
         
+    } else if (modeChoice == 4) {
+        // CROSS-VALIDATION MODE
+        if (testChoice == 1) {
+            cout << "\n--- Cross-Validation Configuration ---" << endl;
+            cout << "Enter the number of trees: ";
+            int numTrees;
+            cin >> numTrees;
+
+            if (numTrees <= 0) {
+                cout << "Invalid number of trees! Using default: 50" << endl;
+                numTrees = 50;
+            }
+
+            cout << "Enter the number of folds: ";
+            int numFolds;
+            cin >> numFolds;
+
+            if (numFolds < 2) {
+                cout << "Invalid number of folds! Using default: 5" << endl;
+                numFolds = 5;
+            }
+
+            benchmark_cross_validation(dataset_config, numTrees, numFolds);
+            
+        } else {
+            cout << "Cross-validation is only available for Random Forest (option 1)." << endl;
+            exit(1);
+        }
+        
+    } else if (modeChoice == 5) {
+        // REPEATED BENCHMARK MODE
+        if (testChoice != 1 && testChoice != 2) {
+            cout << "Invalid choice!" << endl;
+            exit(1);
+        }
+        
+        cout << "\n--- Repeated Benchmark Configuration ---" << endl;
+        int numTrees = 0;  // 0 = decision tree
+        if (testChoice == 1) {
+            cout << "Enter the number of trees: ";
+            cin >> numTrees;
+            
+            if (numTrees <= 0) {
+                cout << "Invalid number of trees! Using default: 100" << endl;
+                numTrees = 100;
+            }
+        }
+        
+        HarnessConfig harness;
+        cout << "Enter the number of timed repetitions: ";
+        cin >> harness.repetitions;
+        
+        if (harness.repetitions < 2) {
+            cout << "Invalid number of repetitions! Using default: 5" << endl;
+            harness.repetitions = 5;
+        }
+        
+        cout << "Enter the number of threads (0 = all " << omp_get_max_threads() << "): ";
+        cin >> harness.num_threads;
+        
+        cout << "Enter an output file prefix for JSON/CSV results (- to skip): ";
+        string prefix;
+        cin >> prefix;
+        if (prefix != "-") {
+            harness.json_path = prefix + ".json";
+            harness.csv_path = prefix + ".csv";
+        }
+        
+        benchmark_repeated(dataset_config, numTrees, harness);
+        
+    } else if (modeChoice == 6) {
+        // THREAD SCALING MODE
+        if (testChoice != 1) {
+            cout << "Thread scaling is only available for Random Forest (option 1)." << endl;
+            exit(1);
+        }
+        
+        cout << "\n--- Thread Scaling Configuration ---" << endl;
+        cout << "Enter the number of trees: ";
+        int numTrees;
+        cin >> numTrees;
+        
+        if (numTrees <= 0) {
+            cout << "Invalid number of trees! Using default: 50" << endl;
+            numTrees = 50;
+        }
+        
+        HarnessConfig harness;
+        harness.repetitions = 3;
+        cout << "Enter the maximum number of threads (0 = all " << omp_get_num_procs() << " logical CPUs): ";
+        cin >> harness.num_threads;
+        
+        cout << "Enter a CSV output file (- to skip): ";
+        string csvPath;
+        cin >> csvPath;
+        if (csvPath != "-") {
+            harness.csv_path = csvPath;
+        }
+        
+        benchmark_scaling(dataset_config, numTrees, harness);
+        
     } else {
         cout << "Invalid mode choice!" << endl;
         exit(1);
@@ -171,7 +327,637 @@ void menu() {
     cout << "========================================" << endl;
 }
 
-int main() {
+// ==================== Command Line (serving) ====================
+
+// An all-digit endpoint is a localhost TCP port, anything else a Unix socket path
+static void parse_endpoint(const string& endpoint, string& socket_path, int& tcp_port) {
+    bool is_port = !endpoint.empty() && all_of(endpoint.begin(), endpoint.end(), [](unsigned char ch) { return isdigit(ch); });
+    if (is_port) {
+        tcp_port = stoi(endpoint);
+    } else {
+        socket_path = endpoint;
+    }
+}
+
+// forests train-model <dataset 1-4> <num_trees> <model_out>
+static int train_model_command(int argc, char** argv) {
+    if (argc < 5) {
+        cerr << "Usage: " << argv[0] << " train-model <dataset 1-4> <num_trees> <model_out>" << endl;
+        return 1;
+    }
+
+    DatasetConfig dataset_config = get_dataset_config(stoi(argv[2]));
+    data_frame df = load_dataset(dataset_config);
+    if (dataset_config.needs_encoding) {
+        df.get_string_column(dataset_config.target_col)->fit_encoding();
+    }
+
+    random_forest_config rf_config;
+    rf_config.num_trees = stoi(argv[3]);
+    rf_config.bootstrap_sample_ratio = 0.55;
+
+    tree_growing_config growing_config;
+    growing_config.criterion = tree_growing_config::SplitCriterion::GINI;
+
+    tree_hyperparameters hp_config;
+    hp_config.max_depth = 300;
+    hp_config.min_examples_per_leaf = 20;
+
+    random_forest forest;
+    forest.rf_config = &rf_config;
+    forest.growing_config = &growing_config;
+    forest.hp_config = &hp_config;
+    forest.fit(df, dataset_config.feature_cols, dataset_config.target_col);
+    forest.save(argv[4]);
+
+    cout << "Saved " << forest.get_num_trees() << " trees trained on " << df.get_num_rows()
+         << " rows of " << dataset_config.path << " to " << argv[4] << endl;
+    return 0;
+}
+
+// Helper: --metrics-file / --metrics-port / --metrics-interval-ms (Prometheus text export)
+static void metrics_from_options(const cli_options& options, metrics_exporter& exporter) {
+    exporter.file_path = options.get_string("metrics_file", "");
+    exporter.http_port = options.get_int("metrics_port", 0);
+    exporter.interval_ms = options.get_int("metrics_interval_ms", exporter.interval_ms);
+    if (exporter.interval_ms <= 0) {
+        throw invalid_argument("--metrics-interval-ms must be positive");
+    }
+}
+
+// forests serve <model> <socket_path|port> [max_batch_rows] [max_wait_us]
+static int serve_command(int argc, char** argv) {
+    // Positional arguments end at the first --flag (metrics options)
+    int positional = 1;
+    while (positional < argc && string(argv[positional]).rfind("--", 0) != 0) ++positional;
+    if (positional < 4) {
+        cerr << "Usage: " << argv[0] << " serve <model> <socket_path|port> [max_batch_rows] [max_wait_us]"
+             << " [--metrics-file f] [--metrics-port n]" << endl;
+        return 1;
+    }
+    cli_options options = cli_options::parse(argc, argv, positional);
+    metrics_exporter exporter;
+    metrics_from_options(options, exporter);
+    options.check_all_used();
+
+    random_forest forest = random_forest::load(argv[2]);
+
+    server_config config;
+    parse_endpoint(argv[3], config.socket_path, config.tcp_port);
+    if (positional > 4) config.max_batch_rows = stoul(argv[4]);
+    if (positional > 5) config.max_wait_us = stoi(argv[5]);
+    exporter.start();
+
+    scoring_server server;
+    server.forest = &forest;
+    server.config = &config;
+
+    cout << "Serving " << forest.get_num_trees() << " trees on " << argv[3]
+         << " (micro-batches of up to " << config.max_batch_rows << " rows, "
+         << config.max_wait_us << " us max wait). Send SHUTDOWN to stop." << endl;
+    server.run();
+    exporter.stop();
+
+    server_stats stats = server.get_stats();
+    cout << "Served " << stats.requests << " requests in " << stats.batches << " batches"
+         << " (mean batch " << stats.mean_batch_rows << ", p50 " << stats.p50_latency_us
+         << " us, p99 " << stats.p99_latency_us << " us)" << endl;
+    return 0;
+}
+
+// forests loadgen <socket_path|port> <csv> [clients] [requests_per_client]
+static int loadgen_command(int argc, char** argv) {
+    if (argc < 4) {
+        cerr << "Usage: " << argv[0] << " loadgen <socket_path|port> <csv> [clients] [requests_per_client]" << endl;
+        return 1;
+    }
+
+    load_test_config config;
+    parse_endpoint(argv[2], config.socket_path, config.tcp_port);
+    config.csv_path = argv[3];
+    if (argc > 4) config.num_clients = stoi(argv[4]);
+    if (argc > 5) config.requests_per_client = stoi(argv[5]);
+
+    load_test_result result = run_load_test(config);
+
+    cout << "Requests:    " << result.requests << " (" << result.errors << " errors)" << endl;
+    cout << "Wall time:   " << result.wall_ms << " ms" << endl;
+    cout << "Throughput:  " << result.throughput_rps << " req/s" << endl;
+    cout << "Latency p50: " << result.p50_latency_us << " us" << endl;
+    cout << "Latency p99: " << result.p99_latency_us << " us" << endl;
+    cout << "Latency max: " << result.max_latency_us << " us" << endl;
+    return result.errors == 0 ? 0 : 1;
+}
+
+// forests export-cpp <model> <out.hpp> [name]
+static int export_cpp_command(int argc, char** argv) {
+    if (argc < 4) {
+        cerr << "Usage: " << argv[0] << " export-cpp <model> <out.hpp> [name]" << endl;
+        return 1;
+    }
+
+    random_forest forest = random_forest::load(argv[2]);
+    string name = argc > 4 ? argv[4] : "forest";
+    forest.export_cpp(argv[3], name);
+
+    cout << "Wrote " << forest.get_num_trees() << " trees as C++ to " << argv[3]
+         << " (entry point " << name << "_predict)" << endl;
+    return 0;
+}
+
+// forests compact-check <model> <csv>
+static int compact_check_command(int argc, char** argv) {
+    if (argc < 4) {
+        cerr << "Usage: " << argv[0] << " compact-check <model> <csv>" << endl;
+        return 1;
+    }
+
+    random_forest forest = random_forest::load(argv[2]);
+    compact_forest compact = forest.compact();
+    data_frame df = data_frame::import_from(argv[3]);
+    compact_check check = forest.check_compact(compact, df);
+
+    cout << "Model size:        " << check.full_bytes << " bytes full, " << check.compact_bytes
+         << " bytes compact (" << (double)check.full_bytes / check.compact_bytes << "x smaller)" << endl;
+    cout << "Rows compared:     " << check.rows << endl;
+    cout << "Class mismatches:  " << check.class_mismatches << endl;
+    cout << "Max proba error:   " << check.max_probability_error << endl;
+    if (check.full_accuracy >= 0) {
+        cout << "Accuracy:          " << check.full_accuracy << " full, " << check.compact_accuracy << " compact" << endl;
+    }
+    return check.class_mismatches == 0 ? 0 : 1;
+}
+
+// ==================== Command Line (train / predict / benchmark / tune) ====================
+
+// Helper: Dataset from options: dataset=1-4 (or diabetes, penguins, drybean, synthetic),
+// or data=<csv> with target=<column> [features=a,b,...]; features/target also override presets
+static DatasetConfig dataset_from_options(const cli_options& options) {
+    DatasetConfig dataset_config;
+    if (options.has("data")) {
+        dataset_config.path = options.get_string("data", "");
+        dataset_config.target_col = options.get_string("target", "");
+        if (dataset_config.target_col.empty()) {
+            throw invalid_argument("--data needs --target <column>");
+        }
+        
+        // Features default to every other column; string targets need an encoding
+        csv_chunk_reader reader(dataset_config.path);
+        vector<vector<string>> rows;
+        reader.read_chunk(rows, 1000);
+        const vector<string>& headers = reader.get_headers();
+        size_t target_pos = find(headers.begin(), headers.end(), dataset_config.target_col) - headers.begin();
+        if (target_pos == headers.size()) {
+            throw invalid_argument("Target column not found in " + dataset_config.path + ": " + dataset_config.target_col);
+        }
+        vector<string> target_values;
+        for (const auto& row : rows) {
+            if (target_pos < row.size()) target_values.push_back(row[target_pos]);
+        }
+        dataset_config.needs_encoding = infer_column_type(target_values) == "string";
+        for (const string& header : headers) {
+            if (header != dataset_config.target_col) dataset_config.feature_cols.push_back(header);
+        }
+    } else {
+        string name = options.get_string("dataset", "1");
+        int choice = name == "diabetes" ? 1 : name == "penguins" ? 2 : name == "drybean" ? 3 : name == "synthetic" ? 4 : 0;
+        if (choice == 0) {
+            choice = options.get_int("dataset", 1);
+        }
+        if (choice < 1 || choice > 4) {
+            throw invalid_argument("Unknown dataset: " + name + " (expected 1-4, diabetes, penguins, drybean or synthetic)");
+        }
+        
+        if (choice == 4) {
+            synthetic_config synthetic;
+            synthetic.num_rows = options.get_size("rows", synthetic.num_rows);
+            synthetic.num_numeric_features = options.get_int("numeric_features", synthetic.num_numeric_features);
+            synthetic.num_categorical_features = options.get_int("categorical_features", synthetic.num_categorical_features);
+            synthetic.categories_per_feature = options.get_int("categories_per_feature", synthetic.categories_per_feature);
+            synthetic.num_classes = options.get_int("classes", synthetic.num_classes);
+            synthetic.class_separation = options.get_double("class_separation", synthetic.class_separation);
+            synthetic.noise = options.get_double("noise", synthetic.noise);
+            synthetic.imbalance = options.get_double("imbalance", synthetic.imbalance);
+            synthetic.seed = options.get_int("synthetic_seed", synthetic.seed);
+            dataset_config = get_synthetic_dataset_config(synthetic);
+        } else {
+            dataset_config = get_dataset_config(choice);
+            dataset_config.target_col = options.get_string("target", dataset_config.target_col);
+        }
+    }
+    
+    if (options.has("features")) {
+        dataset_config.feature_cols = options.get_list("features");
+    }
+    
+    // A sample weight column is never a feature
+    string weight_column = options.get_string("weight_column", "");
+    auto& features = dataset_config.feature_cols;
+    features.erase(remove(features.begin(), features.end(), weight_column), features.end());
+    return dataset_config;
+}
+
+// Helper: --weight-column col and --class-weights balanced|w0,w1,...
+static void weights_from_options(const cli_options& options, tree_growing_config& growing_config) {
+    growing_config.weight_column = options.get_string("weight_column", "");
+    if (options.get_string("class_weights", "") == "balanced") {
+        growing_config.balance_classes = true;
+    } else {
+        growing_config.class_weights = options.get_double_list("class_weights", {});
+    }
+}
+
+// Helper: The tree_growing_config / random_forest_config fields tune does not search over
+static void untuned_model_from_options(const cli_options& options, tree_growing_config& growing_config,
+                                       random_forest_config& rf_config) {
+    growing_config.max_features_per_split = options.get_int("max_features_per_split", -1);
+    growing_config.use_parallel = options.get_bool("tree_parallel", false);
+    growing_config.min_samples_for_parallel = options.get_int("min_samples_for_parallel", 100);
+    growing_config.max_parallel_depth = options.get_int("max_parallel_depth", 8);
+    weights_from_options(options, growing_config);
+    
+    rf_config.random_seed = options.get_int("seed", 42);
+    rf_config.use_parallel = options.get_bool("forest_parallel", true);
+    rf_config.max_samples_per_tree = options.get_size("max_samples_per_tree", 0);
+}
+
+// Helper: Every tree_hyperparameters / tree_growing_config / random_forest_config field,
+// defaulting to the values the benchmarks use
+static void model_from_options(const cli_options& options, tree_hyperparameters& hp_config,
+                               tree_growing_config& growing_config, random_forest_config& rf_config) {
+    hp_config.max_depth = options.get_int("max_depth", 300);
+    hp_config.min_examples_per_leaf = options.get_int("min_examples_per_leaf", 20);
+    
+    string criterion = options.get_string("criterion", "gini");
+    if (criterion == "gini") {
+        growing_config.criterion = tree_growing_config::SplitCriterion::GINI;
+    } else if (criterion == "entropy") {
+        growing_config.criterion = tree_growing_config::SplitCriterion::SHANNON_ENTROPY;
+    } else {
+        throw invalid_argument("Unknown criterion: " + criterion + " (expected gini or entropy)");
+    }
+    
+    rf_config.num_trees = options.get_int("num_trees", 100);
+    rf_config.bootstrap_sample_ratio = options.get_double("bootstrap_sample_ratio", 0.55);
+    untuned_model_from_options(options, growing_config, rf_config);
+}
+
+// Helper: Write a candidate as a config file with every key model_from_options reads
+static void write_model_config(ostream& out, const search_candidate& candidate) {
+    const tree_growing_config& growing = candidate.growing;
+    const random_forest_config& forest = candidate.forest;
+    out << "max_depth = " << candidate.hp.max_depth << "\n"
+        << "min_examples_per_leaf = " << candidate.hp.min_examples_per_leaf << "\n"
+        << "criterion = " << (growing.criterion == tree_growing_config::SplitCriterion::GINI ? "gini" : "entropy") << "\n"
+        << "max_features_per_split = " << growing.max_features_per_split << "\n"
+        << "tree_parallel = " << (growing.use_parallel ? "true" : "false") << "\n"
+        << "min_samples_for_parallel = " << growing.min_samples_for_parallel << "\n"
+        << "max_parallel_depth = " << growing.max_parallel_depth << "\n";
+    if (!growing.weight_column.empty()) {
+        out << "weight_column = " << growing.weight_column << "\n";
+    }
+    if (growing.balance_classes) {
+        out << "class_weights = balanced\n";
+    } else if (!growing.class_weights.empty()) {
+        out << "class_weights = ";
+        for (size_t c = 0; c < growing.class_weights.size(); ++c) {
+            out << (c > 0 ? "," : "") << growing.class_weights[c];
+        }
+        out << "\n";
+    }
+    out << "num_trees = " << forest.num_trees << "\n"
+        << "bootstrap_sample_ratio = " << forest.bootstrap_sample_ratio << "\n"
+        << "seed = " << forest.random_seed << "\n"
+        << "forest_parallel = " << (forest.use_parallel ? "true" : "false") << "\n"
+        << "max_samples_per_tree = " << forest.max_samples_per_tree << "\n";
+}
+
+// Helper: threads=N sets the OpenMP thread count (0 = leave the default)
+static void threads_from_options(const cli_options& options) {
+    int threads = options.get_int("threads", 0);
+    if (threads > 0) {
+        omp_set_num_threads(threads);
+    }
+}
+
+static void print_usage(const char* program) {
+    cerr << "Usage: " << program << " <command> [--key=value ...] [--config file]\n"
+         << "\n"
+         << "Commands:\n"
+         << "  train      Fit a forest and save it (--model out) [--test-ratio r reports holdout accuracy]\n"
+         << "             (a float target trains a regression forest; holdout MSE, MAE and R^2)\n"
+         << "             (and log-loss, Brier score, ROC/PR-AUC; --auc-bins n approximates AUCs with n bins)\n"
+         << "  predict    Score a CSV with a saved model (--model m --data in.csv --output out.csv [--probabilities])\n"
+         << "  benchmark  Repeated or scaling benchmark (--mode repeated|scaling --algorithm forest|tree\n"
+         << "             --repetitions n --warmup n --pin-threads --json f --csv f)\n"
+         << "  tune       Grid search (--max-depth 5,10,-1 --min-examples-per-leaf 5,20 --criterion gini,entropy\n"
+         << "             --num-trees 27 --bootstrap-sample-ratio 0.55,1.0 --folds 3 --fold-seed 42 --halving\n"
+         << "             --best-config f; other model keys, e.g. --seed, are fixed for every candidate)\n"
+         << "  importance Impurity and permutation feature importance of a saved model\n"
+         << "             (--model m --data labelled.csv [--repeats 5 --seed 42])\n"
+         << "  train-model, serve, loadgen, export-cpp, compact-check (positional arguments, see README)\n"
+         << "\n"
+         << "Data:    --dataset 1-4|diabetes|penguins|drybean|synthetic, or --data file.csv --target col\n"
+         << "         [--features a,b,...]; synthetic: --rows --numeric-features --categorical-features\n"
+         << "         --categories-per-feature --classes --class-separation --noise --imbalance --synthetic-seed\n"
+         << "Model:   --max-depth --min-examples-per-leaf --criterion --max-features-per-split --tree-parallel\n"
+         << "         --min-samples-for-parallel --max-parallel-depth --num-trees --bootstrap-sample-ratio --seed\n"
+         << "         --forest-parallel --max-samples-per-tree\n"
+         << "Weights: --weight-column col (per-row sample weights) --class-weights balanced|w0,w1,...\n"
+         << "         for train, benchmark and tune\n"
+         << "Threads: --threads n\n"
+         << "Metrics: --metrics-file f (rewritten every --metrics-interval-ms) and/or --metrics-port n\n"
+         << "         (GET http://127.0.0.1:n/metrics) for train, predict, benchmark and serve\n"
+         << "A config file holds the same keys, one 'key = value' per line ('#' comments)." << endl;
+}
+
+// forests train --model out [data] [model] [--test-ratio r]
+static int train_command(const cli_options& options) {
+    DatasetConfig dataset_config = dataset_from_options(options);
+    tree_hyperparameters hp_config;
+    tree_growing_config growing_config;
+    random_forest_config rf_config;
+    model_from_options(options, hp_config, growing_config, rf_config);
+    threads_from_options(options);
+    string model_path = options.get_string("model", "");
+    double test_ratio = options.get_double("test_ratio", 0.0);
+    size_t auc_bins = options.get_size("auc_bins", 0);
+    metrics_exporter exporter;
+    metrics_from_options(options, exporter);
+    options.check_all_used();
+    if (model_path.empty()) {
+        throw invalid_argument("train needs --model <output path>");
+    }
+    exporter.start();
+    
+    data_frame df = load_dataset(dataset_config);
+    
+    // One target encoding for both splits, so codes agree even when a class is
+    // missing from the training or the holdout rows
+    vector<string> class_names;
+    if (auto str_target = dynamic_cast<const string_col*>(df.get_column(dataset_config.target_col))) {
+        str_target->fit_encoding();
+        for (size_t c = 0; c < str_target->num_unique_values(); ++c) class_names.push_back(str_target->decode(c));
+    }
+    
+    data_frame test_df;
+    if (test_ratio > 0) {
+        auto [train_df, holdout_df] = df.train_test_split(test_ratio);
+        df = std::move(train_df);
+        test_df = std::move(holdout_df);
+    }
+    if (!class_names.empty()) {
+        df.get_string_column(dataset_config.target_col)->set_encoding(class_names);
+        if (test_ratio > 0) test_df.get_string_column(dataset_config.target_col)->set_encoding(class_names);
+    }
+    
+    random_forest forest;
+    forest.rf_config = &rf_config;
+    forest.growing_config = &growing_config;
+    forest.hp_config = &hp_config;
+    
+    auto train_start = chrono::high_resolution_clock::now();
+    forest.fit(df, dataset_config.feature_cols, dataset_config.target_col);
+    double train_ms = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - train_start).count();
+    forest.save(model_path);
+    
+    cout << "Trained " << forest.get_num_trees() << " trees on " << df.get_num_rows() << " rows of "
+         << dataset_config.path << " in " << train_ms << " ms, saved to " << model_path << endl;
+    if (test_ratio > 0 && forest.is_regressor()) {
+        cout << "Holdout (" << test_df.get_num_rows() << " rows):" << endl;
+        const float_col* target = dynamic_cast<const float_col*>(test_df.get_column(dataset_config.target_col));
+        metrics::print_regression_report(metrics::regression_scores(forest.predict_values(test_df), target->get_data()), cout);
+    } else if (test_ratio > 0) {
+        vector<int> truth = encoded_targets(test_df, dataset_config.target_col);
+        classification_report report = metrics::report(forest.predict(test_df), truth);
+        cout << "Holdout accuracy (" << test_df.get_num_rows() << " rows): " << report.accuracy << endl;
+        metrics::print_report(report, cout, class_names);
+        cout << endl;
+        metrics::print_probability_report(metrics::probability_scores(forest.predict_proba(test_df), truth, auc_bins),
+                                          cout, class_names);
+    }
+    exporter.stop();
+    return 0;
+}
+
+// forests predict --model m --data in.csv --output out.csv [--probabilities] [--chunk-rows n]
+static int predict_command(const cli_options& options) {
+    string model_path = options.get_string("model", "");
+    string data_path = options.get_string("data", "");
+    string output_path = options.get_string("output", "");
+    scoring_config config;
+    config.write_probabilities = options.get_bool("probabilities", false);
+    config.chunk_rows = options.get_size("chunk_rows", config.chunk_rows);
+    threads_from_options(options);
+    metrics_exporter exporter;
+    metrics_from_options(options, exporter);
+    options.check_all_used();
+    if (model_path.empty() || data_path.empty() || output_path.empty()) {
+        throw invalid_argument("predict needs --model, --data and --output");
+    }
+    exporter.start();
+    
+    random_forest forest = random_forest::load(model_path);
+    batch_scorer scorer;
+    scorer.forest = &forest;
+    scorer.config = &config;
+    scoring_stats stats = scorer.run(data_path, output_path);
+    
+    cout << "Scored " << stats.rows_scored << " rows in " << stats.wall_ms << " ms, predictions written to "
+         << output_path << endl;
+    exporter.stop();
+    return 0;
+}
+
+// forests benchmark [--mode repeated|scaling] [--algorithm forest|tree] [data] [model] [harness]
+static int benchmark_command(const cli_options& options) {
+    DatasetConfig dataset_config = dataset_from_options(options);
+    tree_hyperparameters hp_config;
+    tree_growing_config growing_config;
+    random_forest_config rf_config;
+    model_from_options(options, hp_config, growing_config, rf_config);
+    
+    HarnessConfig harness;
+    harness.warmup_runs = options.get_int("warmup", harness.warmup_runs);
+    harness.repetitions = options.get_int("repetitions", harness.repetitions);
+    harness.num_threads = options.get_int("threads", harness.num_threads);
+    harness.pin_threads = options.get_bool("pin_threads", harness.pin_threads);
+    harness.json_path = options.get_string("json", "");
+    harness.csv_path = options.get_string("csv", "");
+    harness.hp_config = &hp_config;
+    harness.growing_config = &growing_config;
+    harness.rf_config = &rf_config;
+    
+    string mode = options.get_string("mode", "repeated");
+    string algorithm = options.get_string("algorithm", "forest");
+    metrics_exporter exporter;
+    metrics_from_options(options, exporter);
+    options.check_all_used();
+    if (harness.warmup_runs < 0 || harness.repetitions < 1) {
+        throw invalid_argument("--warmup must be >= 0 and --repetitions >= 1");
+    }
+    if (algorithm != "forest" && algorithm != "tree") {
+        throw invalid_argument("Unknown algorithm: " + algorithm + " (expected forest or tree)");
+    }
+    
+    int num_trees = algorithm == "tree" ? 0 : rf_config.num_trees;
+    exporter.start();
+    if (mode == "repeated") {
+        benchmark_repeated(dataset_config, num_trees, harness);
+    } else if (mode == "scaling") {
+        if (algorithm == "tree") {
+            throw invalid_argument("Scaling mode is only available for --algorithm forest");
+        }
+        if (!harness.json_path.empty()) {
+            throw invalid_argument("Scaling mode writes --csv only");
+        }
+        benchmark_scaling(dataset_config, num_trees, harness);
+    } else {
+        throw invalid_argument("Unknown benchmark mode: " + mode + " (expected repeated or scaling)");
+    }
+    exporter.stop();
+    return 0;
+}
+
+// forests tune [data] [lists of values] [untuned model keys] [--folds k] [--fold-seed s] [--halving] [--best-config out]
+static int tune_command(const cli_options& options) {
+    DatasetConfig dataset_config = dataset_from_options(options);
+    
+    search_space space;
+    space.max_depth = options.get_int_list("max_depth", {5, 10, -1});
+    space.min_examples_per_leaf = options.get_int_list("min_examples_per_leaf", {5, 20});
+    space.num_trees = options.get_int_list("num_trees", {27});
+    space.bootstrap_sample_ratio = options.get_double_list("bootstrap_sample_ratio", {0.55, 1.0});
+    untuned_model_from_options(options, space.base_growing, space.base_forest);
+    space.criterion.clear();
+    vector<string> criteria = options.has("criterion") ? options.get_list("criterion") : vector<string>{"gini", "entropy"};
+    for (const string& criterion : criteria) {
+        if (criterion == "gini") {
+            space.criterion.push_back(tree_growing_config::SplitCriterion::GINI);
+        } else if (criterion == "entropy") {
+            space.criterion.push_back(tree_growing_config::SplitCriterion::SHANNON_ENTROPY);
+        } else {
+            throw invalid_argument("Unknown criterion: " + criterion + " (expected gini or entropy)");
+        }
+    }
+    
+    int max_trees = *max_element(space.num_trees.begin(), space.num_trees.end());
+    grid_search_config config;
+    config.num_folds = options.get_int("folds", config.num_folds);
+    config.fold_seed = options.get_int("fold_seed", config.fold_seed);
+    config.num_random_candidates = options.get_int("random_candidates", config.num_random_candidates);
+    config.use_successive_halving = options.get_bool("halving", config.use_successive_halving);
+    config.halving_factor = options.get_int("halving_factor", config.halving_factor);
+    config.min_trees = options.get_int("min_trees", max(1, max_trees / 9));
+    threads_from_options(options);
+    string best_config_path = options.get_string("best_config", "");
+    bool subsample = options.get_bool("subsample", true);
+    options.check_all_used();
+    
+    data_frame df = load_dataset(dataset_config);
+    if (dataset_config.path == "dataset/Dry_Bean_Dataset.csv" && subsample) {
+        auto [subset_df, _] = df.train_test_split(0.75);  // Same 25% subset as the menu
+        df = std::move(subset_df);
+    }
+    
+    grid_search search;
+    search.search_config = &config;
+    search.on_result = [](const search_result& result) {
+        cout << "  [rung " << result.rung << ", " << result.trees_trained << " trees] " << result.mean_accuracy
+             << " +/- " << result.stddev_accuracy << "  " << result.candidate.describe() << endl;
+    };
+    vector<search_result> results = search.run(df, dataset_config.feature_cols, dataset_config.target_col, space);
+    if (results.empty()) {
+        throw runtime_error("Grid search produced no results");
+    }
+    
+    const search_candidate& best = results[0].candidate;
+    cout << "Best: " << results[0].mean_accuracy << " +/- " << results[0].stddev_accuracy
+         << " (" << results[0].trees_trained << " trees)  " << best.describe() << endl;
+    if (!best_config_path.empty()) {
+        ofstream out(best_config_path);
+        out << "# Best of " << results.size() << " candidates, cross-validated accuracy " << results[0].mean_accuracy << "\n";
+        write_model_config(out, best);
+        if (!out) {
+            throw runtime_error("Failed writing config: " + best_config_path);
+        }
+        cout << "Best configuration written to " << best_config_path << " (use with train --config)" << endl;
+    }
+    return 0;
+}
+
+// forests importance --model m --data in.csv [--repeats n] [--seed s]
+static int importance_command(const cli_options& options) {
+    string model_path = options.get_string("model", "");
+    string data_path = options.get_string("data", "");
+    int num_repeats = options.get_int("repeats", 5);
+    unsigned int seed = options.get_int("seed", 42);
+    threads_from_options(options);
+    options.check_all_used();
+    if (model_path.empty() || data_path.empty()) {
+        throw invalid_argument("importance needs --model and --data (with the target column)");
+    }
+    
+    random_forest forest = random_forest::load(model_path);
+    data_frame df = data_frame::import_from(data_path);
+    auto start = chrono::high_resolution_clock::now();
+    permutation_result permutation = forest.permutation_importance(df, num_repeats, seed);
+    double elapsed_ms = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+    const vector<double>& impurity = forest.feature_importances();
+    const vector<string>& names = forest.get_feature_names();
+    
+    // Most important first (by permutation importance)
+    vector<size_t> order(names.size());
+    for (size_t f = 0; f < order.size(); ++f) order[f] = f;
+    stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return permutation.mean_decrease[a] > permutation.mean_decrease[b];
+    });
+    
+    cout << "Baseline " << (forest.is_regressor() ? "R^2 " : "accuracy ") << permutation.baseline_score << " on " << permutation.rows << " rows; "
+         << names.size() << " features x " << num_repeats << " repeats permuted in " << elapsed_ms << " ms\n" << endl;
+    cout << left << setw(24) << "Feature" << right << setw(12) << "Impurity"
+         << setw(16) << "Permutation" << setw(12) << "+/-" << endl;
+    cout << string(64, '-') << endl;
+    cout << fixed << setprecision(4);
+    for (size_t f : order) {
+        cout << left << setw(24) << names[f].substr(0, 23) << right << setw(12);
+        if (impurity.empty()) {
+            cout << "-";
+        } else {
+            cout << impurity[f];
+        }
+        cout << setw(16) << permutation.mean_decrease[f] << setw(12) << permutation.stddev_decrease[f] << endl;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        string command = argv[1];
+        try {
+            if (command == "train-model") return train_model_command(argc, argv);
+            if (command == "serve") return serve_command(argc, argv);
+            if (command == "loadgen") return loadgen_command(argc, argv);
+            if (command == "export-cpp") return export_cpp_command(argc, argv);
+            if (command == "compact-check") return compact_check_command(argc, argv);
+            if (command == "train") return train_command(cli_options::parse(argc, argv, 2));
+            if (command == "predict") return predict_command(cli_options::parse(argc, argv, 2));
+            if (command == "benchmark") return benchmark_command(cli_options::parse(argc, argv, 2));
+            if (command == "tune") return tune_command(cli_options::parse(argc, argv, 2));
+            if (command == "importance") return importance_command(cli_options::parse(argc, argv, 2));
+            if (command == "help" || command == "--help") {
+                print_usage(argv[0]);
+                return 0;
+            }
+        } catch (const exception& e) {
+            cerr << "Error: " << e.what() << endl;
+            return 1;
+        }
+        cerr << "Unknown command: " << command << endl;
+        print_usage(argv[0]);
+        return 1;
+    }
+
     menu();
     return 0;
 }
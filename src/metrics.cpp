@@ -1,6 +1,9 @@
 #include "metrics.hpp"
 #include <cmath>
 #include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <omp.h>
 #include <stdexcept>
 
 using namespace std;
@@ -102,82 +105,555 @@ double metrics::entropy_gain(
     return parent_entropy - weighted_entropy;
 }
 
-// Accuracy
-double metrics::accuracy(const vector<int>& predictions, const vector<int>& labels) {
-    if (predictions.size() != labels.size() || predictions.empty()) {
-        throw invalid_argument("predictions and labels must have same non-zero size");
+// Helper: compute weighted class distribution
+vector<double> metrics::weighted_class_counts(const vector<int>& labels, const vector<double>& weights, int num_classes) {
+    vector<double> counts(num_classes, 0.0);
+    for (size_t i = 0; i < labels.size(); ++i) {
+        if (labels[i] >= 0 && labels[i] < num_classes) {
+            counts[labels[i]] += weights[i];
+        }
     }
+    return counts;
+}
+
+// Weighted Gini impurity
+double metrics::gini_impurity(const vector<double>& class_weights) {
+    double total = 0.0;
+    for (double weight : class_weights) total += weight;
+    if (total <= 0.0) return 0.0;
     
-    int correct = 0;
-    for (size_t i = 0; i < predictions.size(); ++i) {
-        if (predictions[i] == labels[i]) {
-            correct++;
+    double impurity = 1.0;
+    for (double weight : class_weights) {
+        if (weight > 0) {
+            double prob = weight / total;
+            impurity -= prob * prob;
         }
     }
     
-    return static_cast<double>(correct) / predictions.size();
+    return impurity;
 }
 
-// Precision (macro-averaged for multi-class)
-double metrics::precision(const vector<int>& predictions, const vector<int>& labels) {
+// Weighted Shannon entropy
+double metrics::shannon_entropy(const vector<double>& class_weights) {
+    double total = 0.0;
+    for (double weight : class_weights) total += weight;
+    if (total <= 0.0) return 0.0;
+    
+    double entropy = 0.0;
+    for (double weight : class_weights) {
+        if (weight > 0) {
+            double prob = weight / total;
+            entropy -= prob * log2(prob);
+        }
+    }
+    
+    return entropy;
+}
+
+// Helper: Parent impurity minus the weight-averaged child impurities
+static double weighted_gain(
+    const vector<double>& parent_weights,
+    const vector<double>& left_weights,
+    const vector<double>& right_weights,
+    double (*impurity)(const vector<double>&)
+) {
+    double n_parent = 0.0, n_left = 0.0, n_right = 0.0;
+    for (double weight : parent_weights) n_parent += weight;
+    for (double weight : left_weights) n_left += weight;
+    for (double weight : right_weights) n_right += weight;
+    if (n_parent <= 0.0) return 0.0;
+    
+    double left_weight = n_left / n_parent;
+    double right_weight = n_right / n_parent;
+    
+    double weighted_impurity = 
+        left_weight * impurity(left_weights) +
+        right_weight * impurity(right_weights);
+    
+    return impurity(parent_weights) - weighted_impurity;
+}
+
+double metrics::gini_gain(
+    const vector<double>& parent_weights,
+    const vector<double>& left_weights,
+    const vector<double>& right_weights
+) {
+    return weighted_gain(parent_weights, left_weights, right_weights, &metrics::gini_impurity);
+}
+
+double metrics::entropy_gain(
+    const vector<double>& parent_weights,
+    const vector<double>& left_weights,
+    const vector<double>& right_weights
+) {
+    return weighted_gain(parent_weights, left_weights, right_weights, &metrics::shannon_entropy);
+}
+
+// Helper: throw unless predictions and labels pair up
+static void check_sizes(const vector<int>& predictions, const vector<int>& labels) {
     if (predictions.size() != labels.size() || predictions.empty()) {
         throw invalid_argument("predictions and labels must have same non-zero size");
     }
+}
+
+size_t confusion_matrix::total() const {
+    size_t sum = 0;
+    for (size_t count : counts) sum += count;
+    for (size_t count : unmatched) sum += count;
+    return sum;
+}
+
+// Confusion matrix
+confusion_matrix metrics::confusion(const vector<int>& predictions, const vector<int>& labels, int num_classes) {
+    check_sizes(predictions, labels);
+    long n = predictions.size();
     
-    int num_classes = *max_element(labels.begin(), labels.end()) + 1;
-    double total_precision = 0.0;
-    int valid_classes = 0;
+    if (num_classes <= 0) {
+        int largest = 0;
+        #pragma omp parallel for reduction(max:largest)
+        for (long i = 0; i < n; ++i) {
+            largest = max(largest, labels[i]);
+        }
+        num_classes = largest + 1;
+    }
     
-    for (int c = 0; c < num_classes; ++c) {
-        int tp = 0, fp = 0;
-        for (size_t i = 0; i < predictions.size(); ++i) {
-            if (predictions[i] == c) {
-                if (labels[i] == c) tp++;
-                else fp++;
+    confusion_matrix matrix;
+    matrix.num_classes = num_classes;
+    matrix.counts.assign((size_t)num_classes * num_classes, 0);
+    matrix.unmatched.assign(num_classes, 0);
+    size_t invalid = 0;
+    
+    #pragma omp parallel reduction(+:invalid)
+    {
+        vector<size_t> local((size_t)num_classes * num_classes, 0);
+        vector<size_t> local_unmatched(num_classes, 0);
+        
+        #pragma omp for nowait
+        for (long i = 0; i < n; ++i) {
+            // Unsigned compare also rejects negative classes
+            unsigned truth = labels[i], predicted = predictions[i];
+            if (truth >= (unsigned)num_classes) {
+                invalid++;
+            } else if (predicted < (unsigned)num_classes) {
+                local[(size_t)truth * num_classes + predicted]++;
+            } else {
+                local_unmatched[truth]++;
             }
         }
         
-        if (tp + fp > 0) {
-            total_precision += static_cast<double>(tp) / (tp + fp);
-            valid_classes++;
+        #pragma omp critical(confusion_merge)
+        {
+            for (size_t k = 0; k < local.size(); ++k) {
+                matrix.counts[k] += local[k];
+            }
+            for (int c = 0; c < num_classes; ++c) {
+                matrix.unmatched[c] += local_unmatched[c];
+            }
         }
     }
     
-    return valid_classes > 0 ? total_precision / valid_classes : 0.0;
+    if (invalid > 0) {
+        throw invalid_argument(to_string(invalid) + " labels outside [0, " + to_string(num_classes) + ")");
+    }
+    return matrix;
 }
 
-// Recall (macro-averaged for multi-class)
-double metrics::recall(const vector<int>& predictions, const vector<int>& labels) {
-    if (predictions.size() != labels.size() || predictions.empty()) {
-        throw invalid_argument("predictions and labels must have same non-zero size");
-    }
+// Classification report
+classification_report metrics::report(const confusion_matrix& matrix) {
+    int num_classes = matrix.num_classes;
+    classification_report result;
+    result.rows = matrix.total();
+    result.per_class.assign(num_classes, class_report());
     
-    int num_classes = *max_element(labels.begin(), labels.end()) + 1;
-    double total_recall = 0.0;
-    int valid_classes = 0;
+    size_t correct = 0;
+    for (int t = 0; t < num_classes; ++t) {
+        for (int p = 0; p < num_classes; ++p) {
+            size_t count = matrix.at(t, p);
+            result.per_class[t].support += count;
+            result.per_class[p].predicted += count;
+        }
+        if (!matrix.unmatched.empty()) result.per_class[t].support += matrix.unmatched[t];
+        correct += matrix.at(t, t);
+    }
     
+    int predicted_classes = 0, present_classes = 0;
     for (int c = 0; c < num_classes; ++c) {
-        int tp = 0, fn = 0;
-        for (size_t i = 0; i < predictions.size(); ++i) {
-            if (labels[i] == c) {
-                if (predictions[i] == c) tp++;
-                else fn++;
+        class_report& cls = result.per_class[c];
+        double tp = matrix.at(c, c);
+        if (cls.predicted > 0) {
+            cls.precision = tp / cls.predicted;
+            result.macro_precision += cls.precision;
+            predicted_classes++;
+        }
+        if (cls.support > 0) {
+            cls.recall = tp / cls.support;
+            result.macro_recall += cls.recall;
+            present_classes++;
+        }
+        if (cls.precision + cls.recall > 0.0) {
+            cls.f1_score = 2.0 * cls.precision * cls.recall / (cls.precision + cls.recall);
+        }
+        
+        result.weighted_precision += cls.precision * cls.support;
+        result.weighted_recall += cls.recall * cls.support;
+        result.weighted_f1 += cls.f1_score * cls.support;
+    }
+    
+    // Macro F1 over every class that occurs or was predicted
+    int f1_classes = 0;
+    for (const class_report& cls : result.per_class) {
+        if (cls.support > 0 || cls.predicted > 0) {
+            result.macro_f1 += cls.f1_score;
+            f1_classes++;
+        }
+    }
+    
+    if (predicted_classes > 0) result.macro_precision /= predicted_classes;
+    if (present_classes > 0) result.macro_recall /= present_classes;
+    if (f1_classes > 0) result.macro_f1 /= f1_classes;
+    if (result.rows > 0) {
+        result.accuracy = static_cast<double>(correct) / result.rows;
+        result.weighted_precision /= result.rows;
+        result.weighted_recall /= result.rows;
+        result.weighted_f1 /= result.rows;
+    }
+    
+    // Single-label: every miss is one false positive and one false negative
+    result.micro_precision = result.accuracy;
+    result.micro_recall = result.accuracy;
+    result.micro_f1 = result.accuracy;
+    return result;
+}
+
+classification_report metrics::report(const vector<int>& predictions, const vector<int>& labels, int num_classes) {
+    return report(confusion(predictions, labels, num_classes));
+}
+
+void metrics::print_report(const classification_report& report, ostream& out, const vector<string>& class_names) {
+    ios::fmtflags flags = out.flags();
+    streamsize precision = out.precision();
+    
+    out << left << setw(16) << "Class"
+        << right << setw(11) << "Precision"
+        << setw(10) << "Recall"
+        << setw(10) << "F1"
+        << setw(10) << "Support" << endl;
+    out << string(57, '-') << endl;
+    out << fixed << setprecision(4);
+    for (size_t c = 0; c < report.per_class.size(); ++c) {
+        const class_report& cls = report.per_class[c];
+        string name = c < class_names.size() ? class_names[c] : to_string(c);
+        out << left << setw(16) << name.substr(0, 15)
+            << right << setw(11) << cls.precision
+            << setw(10) << cls.recall
+            << setw(10) << cls.f1_score
+            << setw(10) << cls.support << endl;
+    }
+    out << string(57, '-') << endl;
+    out << left << setw(16) << "macro avg" << right << setw(11) << report.macro_precision
+        << setw(10) << report.macro_recall << setw(10) << report.macro_f1 << setw(10) << report.rows << endl;
+    out << left << setw(16) << "weighted avg" << right << setw(11) << report.weighted_precision
+        << setw(10) << report.weighted_recall << setw(10) << report.weighted_f1 << setw(10) << report.rows << endl;
+    out << left << setw(16) << "accuracy" << right << setw(41) << report.accuracy << endl;
+    
+    out.flags(flags);
+    out.precision(precision);
+}
+
+// Helper: throw unless every row has a probability per class and a label in range
+static int check_probabilities(const vector<vector<double>>& probabilities, const vector<int>& labels) {
+    if (probabilities.size() != labels.size() || probabilities.empty()) {
+        throw invalid_argument("probabilities and labels must have same non-zero size");
+    }
+    int num_classes = probabilities[0].size();
+    for (size_t i = 0; i < labels.size(); ++i) {
+        if ((int)probabilities[i].size() != num_classes) {
+            throw invalid_argument("probability rows must all have one value per class");
+        }
+        if (labels[i] < 0 || labels[i] >= num_classes) {
+            throw invalid_argument("label " + to_string(labels[i]) + " outside [0, " + to_string(num_classes) + ")");
+        }
+    }
+    return num_classes;
+}
+
+// Helper: Sort in parallel (one sorted chunk per thread, then pairwise merges in parallel rounds)
+template <typename T, typename Compare>
+static void parallel_sort(vector<T>& data, Compare less) {
+    int chunks = omp_get_max_threads();
+    size_t n = data.size();
+    if (chunks <= 1 || n < 65536) {
+        sort(data.begin(), data.end(), less);
+        return;
+    }
+    
+    vector<size_t> bounds(chunks + 1);
+    for (int c = 0; c <= chunks; ++c) bounds[c] = n * c / chunks;
+    
+    #pragma omp parallel for
+    for (int c = 0; c < chunks; ++c) {
+        sort(data.begin() + bounds[c], data.begin() + bounds[c + 1], less);
+    }
+    for (int width = 1; width < chunks; width *= 2) {
+        #pragma omp parallel for
+        for (int c = 0; c < chunks; c += 2 * width) {
+            if (c + width < chunks) {
+                inplace_merge(data.begin() + bounds[c], data.begin() + bounds[c + width],
+                              data.begin() + bounds[min(c + 2 * width, chunks)], less);
             }
         }
+    }
+}
+
+// Helper: ROC and precision-recall curves swept from the highest score down,
+// one group of tied scores (or one histogram bin) at a time
+struct curve_sweep {
+    double positives, negatives;       // Totals
+    double tp = 0.0, fp = 0.0;
+    double roc_area = 0.0;             // Trapezoids in (fp, tp) counts
+    double average_precision = 0.0;
+    
+    curve_sweep(double positives, double negatives) : positives(positives), negatives(negatives) {}
+    
+    void add_group(double group_positives, double group_negatives) {
+        if (group_positives + group_negatives == 0.0) return;
+        double next_tp = tp + group_positives, next_fp = fp + group_negatives;
+        roc_area += group_negatives * (tp + next_tp) / 2.0;
+        average_precision += group_positives / positives * next_tp / (next_tp + next_fp);
+        tp = next_tp;
+        fp = next_fp;
+    }
+    
+    double roc_auc() const { return roc_area / (positives * negatives); }
+};
+
+// Log-loss
+double metrics::log_loss(const vector<vector<double>>& probabilities, const vector<int>& labels, double eps) {
+    check_probabilities(probabilities, labels);
+    
+    long n = labels.size();
+    double total = 0.0;
+    #pragma omp parallel for reduction(+:total)
+    for (long i = 0; i < n; ++i) {
+        double p = min(max(probabilities[i][labels[i]], eps), 1.0 - eps);
+        total -= log(p);
+    }
+    
+    return total / n;
+}
+
+// Brier score
+double metrics::brier_score(const vector<vector<double>>& probabilities, const vector<int>& labels) {
+    int num_classes = check_probabilities(probabilities, labels);
+    
+    long n = labels.size();
+    double total = 0.0;
+    #pragma omp parallel for reduction(+:total)
+    for (long i = 0; i < n; ++i) {
+        for (int c = 0; c < num_classes; ++c) {
+            double error = probabilities[i][c] - (c == labels[i] ? 1.0 : 0.0);
+            total += error * error;
+        }
+    }
+    
+    return total / n;
+}
+
+// Probability report
+probability_report metrics::probability_scores(
+    const vector<vector<double>>& probabilities,
+    const vector<int>& labels,
+    size_t auc_bins
+) {
+    int num_classes = check_probabilities(probabilities, labels);
+    long n = labels.size();
+    
+    probability_report report;
+    report.rows = n;
+    report.log_loss = log_loss(probabilities, labels);
+    report.brier_score = brier_score(probabilities, labels);
+    report.approximate = auc_bins > 0;
+    report.roc_auc.assign(num_classes, numeric_limits<double>::quiet_NaN());
+    report.pr_auc.assign(num_classes, numeric_limits<double>::quiet_NaN());
+    
+    vector<int> class_counts(num_classes, 0);
+    for (int label : labels) class_counts[label]++;
+    
+    // Exact: reused buffer of (score, is positive), sorted by descending score
+    vector<pair<double, int>> ranked;
+    // Approximate: per-bin positive / negative counts
+    vector<double> bin_positives, bin_negatives;
+    
+    for (int c = 0; c < num_classes; ++c) {
+        double positives = class_counts[c], negatives = n - class_counts[c];
+        if (positives == 0 || negatives == 0) continue;
+        curve_sweep sweep(positives, negatives);
         
-        if (tp + fn > 0) {
-            total_recall += static_cast<double>(tp) / (tp + fn);
-            valid_classes++;
+        if (auc_bins == 0) {
+            ranked.resize(n);
+            #pragma omp parallel for
+            for (long i = 0; i < n; ++i) {
+                ranked[i] = {probabilities[i][c], labels[i] == c};
+            }
+            parallel_sort(ranked, [](const pair<double, int>& a, const pair<double, int>& b) { return a.first > b.first; });
+            
+            for (long i = 0; i < n; ) {
+                long group_positives = 0, group_size = 0;
+                double score = ranked[i].first;
+                for (; i < n && ranked[i].first == score; ++i, ++group_size) {
+                    group_positives += ranked[i].second;
+                }
+                sweep.add_group(group_positives, group_size - group_positives);
+            }
+        } else {
+            bin_positives.assign(auc_bins, 0.0);
+            bin_negatives.assign(auc_bins, 0.0);
+            
+            #pragma omp parallel
+            {
+                vector<size_t> local_positives(auc_bins, 0), local_negatives(auc_bins, 0);
+                
+                #pragma omp for nowait
+                for (long i = 0; i < n; ++i) {
+                    double score = min(max(probabilities[i][c], 0.0), 1.0);
+                    size_t bin = min((size_t)(score * auc_bins), auc_bins - 1);
+                    if (labels[i] == c) local_positives[bin]++;
+                    else local_negatives[bin]++;
+                }
+                
+                #pragma omp critical(auc_histogram_merge)
+                for (size_t b = 0; b < auc_bins; ++b) {
+                    bin_positives[b] += local_positives[b];
+                    bin_negatives[b] += local_negatives[b];
+                }
+            }
+            
+            for (size_t b = auc_bins; b-- > 0; ) {
+                sweep.add_group(bin_positives[b], bin_negatives[b]);
+            }
         }
+        
+        report.roc_auc[c] = sweep.roc_auc();
+        report.pr_auc[c] = sweep.average_precision;
+    }
+    
+    int defined = 0;
+    for (int c = 0; c < num_classes; ++c) {
+        if (std::isnan(report.roc_auc[c])) continue;
+        report.macro_roc_auc += report.roc_auc[c];
+        report.macro_pr_auc += report.pr_auc[c];
+        defined++;
+    }
+    if (defined > 0) {
+        report.macro_roc_auc /= defined;
+        report.macro_pr_auc /= defined;
+    } else {
+        report.macro_roc_auc = report.macro_pr_auc = numeric_limits<double>::quiet_NaN();
     }
     
-    return valid_classes > 0 ? total_recall / valid_classes : 0.0;
+    return report;
+}
+
+void metrics::print_probability_report(const probability_report& report, ostream& out, const vector<string>& class_names) {
+    ios::fmtflags flags = out.flags();
+    streamsize precision = out.precision();
+    
+    out << left << setw(16) << "Class"
+        << right << setw(11) << "ROC-AUC"
+        << setw(10) << "PR-AUC" << endl;
+    out << string(37, '-') << endl;
+    out << fixed << setprecision(4);
+    for (size_t c = 0; c < report.roc_auc.size(); ++c) {
+        string name = c < class_names.size() ? class_names[c] : to_string(c);
+        out << left << setw(16) << name.substr(0, 15)
+            << right << setw(11) << report.roc_auc[c]
+            << setw(10) << report.pr_auc[c] << endl;
+    }
+    out << string(37, '-') << endl;
+    out << left << setw(16) << "macro avg" << right << setw(11) << report.macro_roc_auc
+        << setw(10) << report.macro_pr_auc << endl;
+    out << "Log-loss:    " << report.log_loss << endl;
+    out << "Brier score: " << report.brier_score << endl;
+    if (report.approximate) {
+        out << "(AUCs approximated from a score histogram)" << endl;
+    }
+    
+    out.flags(flags);
+    out.precision(precision);
+}
+
+// Regression report
+regression_report metrics::regression_scores(const vector<double>& predictions, const vector<double>& truth) {
+    if (predictions.size() != truth.size() || predictions.empty()) {
+        throw invalid_argument("predictions and truth must have same non-zero size");
+    }
+    
+    long n = truth.size();
+    double truth_sum = 0.0;
+    #pragma omp parallel for reduction(+:truth_sum)
+    for (long i = 0; i < n; ++i) {
+        truth_sum += truth[i];
+    }
+    double truth_mean = truth_sum / n;
+    
+    double squared_error = 0.0, absolute_error = 0.0, total_squares = 0.0;
+    #pragma omp parallel for reduction(+:squared_error, absolute_error, total_squares)
+    for (long i = 0; i < n; ++i) {
+        double error = predictions[i] - truth[i];
+        squared_error += error * error;
+        absolute_error += fabs(error);
+        total_squares += (truth[i] - truth_mean) * (truth[i] - truth_mean);
+    }
+    
+    regression_report report;
+    report.rows = n;
+    report.mean_squared_error = squared_error / n;
+    report.root_mean_squared_error = sqrt(report.mean_squared_error);
+    report.mean_absolute_error = absolute_error / n;
+    report.r2 = total_squares > 0.0 ? 1.0 - squared_error / total_squares : 0.0;
+    return report;
+}
+
+void metrics::print_regression_report(const regression_report& report, ostream& out) {
+    out << "MSE:  " << report.mean_squared_error << endl;
+    out << "RMSE: " << report.root_mean_squared_error << endl;
+    out << "MAE:  " << report.mean_absolute_error << endl;
+    out << "R^2:  " << report.r2 << endl;
+}
+
+// Accuracy
+double metrics::accuracy(const vector<int>& predictions, const vector<int>& labels) {
+    check_sizes(predictions, labels);
+    
+    long n = predictions.size();
+    long correct = 0;
+    #pragma omp parallel for reduction(+:correct)
+    for (long i = 0; i < n; ++i) {
+        correct += predictions[i] == labels[i];
+    }
+    
+    return static_cast<double>(correct) / n;
+}
+
+// Precision (macro-averaged over the classes that were predicted)
+double metrics::precision(const vector<int>& predictions, const vector<int>& labels) {
+    return report(predictions, labels).macro_precision;
+}
+
+// Recall (macro-averaged over the classes that occur)
+double metrics::recall(const vector<int>& predictions, const vector<int>& labels) {
+    return report(predictions, labels).macro_recall;
 }
 
 // F1 Score
 double metrics::f1_score(const vector<int>& predictions, const vector<int>& labels) {
-    double prec = precision(predictions, labels);
-    double rec = recall(predictions, labels);
+    return f1_score(report(predictions, labels));
+}
+
+// F1 Score of a report's macro precision and recall
+double metrics::f1_score(const classification_report& report) {
+    double prec = report.macro_precision;
+    double rec = report.macro_recall;
     
     if (prec + rec == 0.0) return 0.0;
     
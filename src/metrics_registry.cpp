@@ -0,0 +1,303 @@
+/*
+Runtime metrics registry with Prometheus text export (file or local HTTP)
+*/
+
+#include "metrics_registry.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sstream>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+
+int metric_shard_index() {
+    static atomic<int> next_index{0};
+    thread_local int index = next_index.fetch_add(1, memory_order_relaxed) % METRIC_SHARDS;
+    return index;
+}
+
+// ==================== Metric Types ====================
+
+uint64_t metric_counter::value() const {
+    uint64_t total = 0;
+    for (const auto& s : shards) total += s.value.load(memory_order_relaxed);
+    return total;
+}
+
+metric_histogram::metric_histogram(const vector<double>& upper_bounds) : bounds(upper_bounds) {
+    sort(bounds.begin(), bounds.end());
+    bounds.erase(unique(bounds.begin(), bounds.end()), bounds.end());
+    shards.reset(new shard[METRIC_SHARDS]);
+    for (int s = 0; s < METRIC_SHARDS; ++s) {
+        shards[s].buckets.reset(new atomic<uint64_t>[bounds.size() + 1]);
+        for (size_t b = 0; b <= bounds.size(); ++b) shards[s].buckets[b].store(0, memory_order_relaxed);
+    }
+}
+
+void metric_histogram::observe(double value) {
+    shard& s = shards[metric_shard_index()];
+    size_t bucket = lower_bound(bounds.begin(), bounds.end(), value) - bounds.begin();  // First bound >= value
+    s.buckets[bucket].fetch_add(1, memory_order_relaxed);
+
+    // Uncontended in practice (one shard per thread), so the CAS loop rarely repeats
+    double sum = s.sum.load(memory_order_relaxed);
+    while (!s.sum.compare_exchange_weak(sum, sum + value, memory_order_relaxed)) {}
+}
+
+void metric_histogram::snapshot(vector<uint64_t>& bucket_counts, double& sum) const {
+    bucket_counts.assign(bounds.size() + 1, 0);
+    sum = 0.0;
+    for (int s = 0; s < METRIC_SHARDS; ++s) {
+        for (size_t b = 0; b <= bounds.size(); ++b) {
+            bucket_counts[b] += shards[s].buckets[b].load(memory_order_relaxed);
+        }
+        sum += shards[s].sum.load(memory_order_relaxed);
+    }
+}
+
+vector<double> metric_histogram::exponential_bounds(double start, double factor, int count) {
+    vector<double> result;
+    for (int i = 0; i < count; ++i) {
+        result.push_back(start);
+        start *= factor;
+    }
+    return result;
+}
+
+// ==================== Registry ====================
+
+metrics_registry& metrics_registry::global() {
+    static metrics_registry registry;
+    return registry;
+}
+
+metric_counter& metrics_registry::get_counter(const string& name, const string& help) {
+    lock_guard<mutex> guard(lock);
+    entry& e = metrics[name];
+    if (e.gauge || e.histogram) {
+        throw invalid_argument("Metric " + name + " is already registered with another type");
+    }
+    if (!e.counter) {
+        e.help = help;
+        e.counter.reset(new metric_counter());
+    }
+    return *e.counter;
+}
+
+metric_gauge& metrics_registry::get_gauge(const string& name, const string& help) {
+    lock_guard<mutex> guard(lock);
+    entry& e = metrics[name];
+    if (e.counter || e.histogram) {
+        throw invalid_argument("Metric " + name + " is already registered with another type");
+    }
+    if (!e.gauge) {
+        e.help = help;
+        e.gauge.reset(new metric_gauge());
+    }
+    return *e.gauge;
+}
+
+metric_histogram& metrics_registry::get_histogram(const string& name, const string& help, const vector<double>& upper_bounds) {
+    lock_guard<mutex> guard(lock);
+    entry& e = metrics[name];
+    if (e.counter || e.gauge) {
+        throw invalid_argument("Metric " + name + " is already registered with another type");
+    }
+    if (!e.histogram) {
+        e.help = help;
+        e.histogram.reset(new metric_histogram(upper_bounds));
+    }
+    return *e.histogram;
+}
+
+// Helper: Prometheus sample value (shortest of 15/17 digits that round-trips, +Inf spelled out)
+static string format_value(double value) {
+    if (std::isinf(value)) return value > 0 ? "+Inf" : "-Inf";
+    ostringstream text;
+    text.precision(15);
+    text << value;
+    if (stod(text.str()) != value) {
+        text.str("");
+        text.precision(17);
+        text << value;
+    }
+    return text.str();
+}
+
+void metrics_registry::write_prometheus(ostream& out) const {
+    lock_guard<mutex> guard(lock);
+    for (const auto& [name, e] : metrics) {
+        out << "# HELP " << name << " " << e.help << "\n";
+        if (e.counter) {
+            out << "# TYPE " << name << " counter\n";
+            out << name << " " << e.counter->value() << "\n";
+        } else if (e.gauge) {
+            out << "# TYPE " << name << " gauge\n";
+            out << name << " " << format_value(e.gauge->value()) << "\n";
+        } else if (e.histogram) {
+            vector<uint64_t> counts;
+            double sum;
+            e.histogram->snapshot(counts, sum);
+            const vector<double>& bounds = e.histogram->get_bounds();
+
+            out << "# TYPE " << name << " histogram\n";
+            uint64_t cumulative = 0;
+            for (size_t b = 0; b < counts.size(); ++b) {
+                cumulative += counts[b];
+                string le = b < bounds.size() ? format_value(bounds[b]) : "+Inf";
+                out << name << "_bucket{le=\"" << le << "\"} " << cumulative << "\n";
+            }
+            out << name << "_sum " << format_value(sum) << "\n";
+            out << name << "_count " << cumulative << "\n";
+        }
+    }
+}
+
+void metrics_registry::write_prometheus_file(const string& path) const {
+    string temp_path = path + ".tmp";
+    {
+        ofstream out(temp_path);
+        if (!out.is_open()) {
+            throw runtime_error("Could not open file for writing: " + temp_path);
+        }
+        write_prometheus(out);
+        if (!out) {
+            throw runtime_error("Failed writing metrics: " + temp_path);
+        }
+    }
+    if (rename(temp_path.c_str(), path.c_str()) != 0) {
+        throw runtime_error("Could not replace " + path + ": " + strerror(errno));
+    }
+}
+
+// ==================== Exporter ====================
+
+metrics_exporter::~metrics_exporter() {
+    try {
+        stop();
+    } catch (const exception&) {
+        // Final file write failed; nothing left to report it to
+    }
+}
+
+void metrics_exporter::open_listener() {
+    listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        throw runtime_error(string("socket() failed: ") + strerror(errno));
+    }
+
+    int reuse = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(http_port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(listen_fd, 16) < 0) {
+        string reason = strerror(errno);
+        close(listen_fd);
+        listen_fd = -1;
+        throw runtime_error("Could not listen for metrics on port " + to_string(http_port) + ": " + reason);
+    }
+}
+
+// Answer every connection waiting on the listener (one request each, then close)
+void metrics_exporter::serve_pending_requests() {
+    while (true) {
+        pollfd waiting = {listen_fd, POLLIN, 0};
+        if (poll(&waiting, 1, 0) <= 0) return;
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) return;
+
+        timeval timeout = {1, 0};  // A silent client must not stall the exporter
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        char buffer[2048];
+        ssize_t received = recv(fd, buffer, sizeof(buffer) - 1, 0);
+        string request(buffer, received > 0 ? received : 0);
+
+        string status = "200 OK";
+        string body;
+        if (request.rfind("GET /metrics", 0) == 0 || request.rfind("GET / ", 0) == 0) {
+            ostringstream text;
+            source->write_prometheus(text);
+            body = text.str();
+        } else {
+            status = "404 Not Found";
+            body = "Only GET /metrics is served\n";
+        }
+
+        string response = "HTTP/1.0 " + status + "\r\n"
+                          "Content-Type: text/plain; version=0.0.4\r\n"
+                          "Content-Length: " + to_string(body.size()) + "\r\n"
+                          "Connection: close\r\n\r\n" + body;
+        size_t sent = 0;
+        while (sent < response.size()) {
+            ssize_t n = send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) break;
+            sent += n;
+        }
+        close(fd);
+    }
+}
+
+void metrics_exporter::start() {
+    if (worker.joinable() || (file_path.empty() && http_port <= 0)) return;
+    if (http_port > 0) {
+        open_listener();
+    }
+
+    stop_requested = false;
+    worker = thread([this] {
+        auto next_write = chrono::steady_clock::now();
+        unique_lock<mutex> guard(wake_lock);
+        while (!stop_requested) {
+            if (!file_path.empty() && chrono::steady_clock::now() >= next_write) {
+                try {
+                    source->write_prometheus_file(file_path);
+                } catch (const exception&) {
+                    // Keep exporting; the final write in stop() reports persistent errors
+                }
+                next_write += chrono::milliseconds(interval_ms);
+            }
+
+            if (listen_fd >= 0) {
+                // Poll in short steps so requests are answered promptly and stop() is noticed
+                guard.unlock();
+                pollfd waiting = {listen_fd, POLLIN, 0};
+                if (poll(&waiting, 1, 50) > 0) serve_pending_requests();
+                guard.lock();
+            } else {
+                wake.wait_until(guard, next_write, [this] { return stop_requested; });
+            }
+        }
+    });
+}
+
+void metrics_exporter::stop() {
+    if (!worker.joinable()) return;
+    {
+        lock_guard<mutex> guard(wake_lock);
+        stop_requested = true;
+    }
+    wake.notify_one();
+    worker.join();
+
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        listen_fd = -1;
+    }
+    if (!file_path.empty()) {
+        source->write_prometheus_file(file_path);
+    }
+}
@@ -0,0 +1,154 @@
+/*
+Per-thread training phase profiler
+*/
+
+#include "profiler.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+static const int NUM_PHASES = (int)profile_phase::COUNT;
+static const size_t MAX_EVENTS_PER_THREAD = 1000000;
+
+static const char* PHASE_NAMES[NUM_PHASES] = {
+    "tree_fit", "bootstrap", "node_alloc", "label_gather", "split_search",
+    "sort", "split_scoring", "partition", "task_wait"
+};
+
+struct trace_event {
+    int64_t start_ns;
+    int64_t end_ns;
+    profile_phase phase;
+};
+
+// One thread's recordings, padded so neighbouring slots never share a cache line
+struct alignas(64) thread_profile {
+    int thread_id;
+    int64_t total_ns[NUM_PHASES] = {};
+    int64_t calls[NUM_PHASES] = {};
+    vector<trace_event> events;
+};
+
+static mutex registry_lock;
+static vector<unique_ptr<thread_profile>> registry;  // Slots outlive their threads
+static const chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+
+static thread_profile& local_profile() {
+    thread_local thread_profile* slot = nullptr;
+    if (!slot) {
+        lock_guard<mutex> guard(registry_lock);
+        registry.emplace_back(new thread_profile());
+        slot = registry.back().get();
+        slot->thread_id = registry.size() - 1;
+    }
+    return *slot;
+}
+
+int64_t profiler::now_ns() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - epoch).count();
+}
+
+void profiler::record(profile_phase phase, int64_t start_ns, int64_t end_ns) {
+    thread_profile& profile = local_profile();
+    profile.total_ns[(int)phase] += end_ns - start_ns;
+    profile.calls[(int)phase]++;
+    if (profile.events.size() < MAX_EVENTS_PER_THREAD) {
+        profile.events.push_back({start_ns, end_ns, phase});
+    }
+}
+
+void profiler::reset() {
+    lock_guard<mutex> guard(registry_lock);
+    for (auto& profile : registry) {
+        fill(profile->total_ns, profile->total_ns + NUM_PHASES, 0);
+        fill(profile->calls, profile->calls + NUM_PHASES, 0);
+        profile->events.clear();
+    }
+}
+
+void profiler::print_breakdown(ostream& out) {
+    if (!is_enabled()) {
+        out << "Profiling is disabled (configure with -DPRF_PROFILE=ON)." << endl;
+        return;
+    }
+
+    lock_guard<mutex> guard(registry_lock);
+
+    int64_t total_ns[NUM_PHASES] = {};
+    int64_t calls[NUM_PHASES] = {};
+    int64_t max_thread_ns[NUM_PHASES] = {};
+    int active_threads = 0;
+    for (const auto& profile : registry) {
+        bool active = false;
+        for (int p = 0; p < NUM_PHASES; ++p) {
+            total_ns[p] += profile->total_ns[p];
+            calls[p] += profile->calls[p];
+            max_thread_ns[p] = max(max_thread_ns[p], profile->total_ns[p]);
+            active = active || profile->calls[p] > 0;
+        }
+        active_threads += active;
+    }
+
+    double fit_ms = total_ns[(int)profile_phase::TREE_FIT] / 1e6;
+
+    out << "\n=== TRAINING PROFILE (" << active_threads << " threads, times summed over threads) ===" << endl;
+    out << left << setw(16) << "Phase"
+        << right << setw(12) << "Calls"
+        << setw(14) << "Total (ms)"
+        << setw(12) << "Mean (us)"
+        << setw(12) << "% of fit"
+        << setw(16) << "Max thread (ms)" << endl;
+    out << string(82, '-') << endl;
+
+    for (int p = 0; p < NUM_PHASES; ++p) {
+        if (calls[p] == 0) continue;
+        double phase_ms = total_ns[p] / 1e6;
+        out << left << setw(16) << PHASE_NAMES[p]
+            << right << setw(12) << calls[p]
+            << setw(14) << fixed << setprecision(2) << phase_ms
+            << setw(12) << phase_ms * 1000.0 / calls[p]
+            << setw(12) << setprecision(1);
+        if (fit_ms > 0) {
+            out << 100.0 * phase_ms / fit_ms;
+        } else {
+            out << "-";
+        }
+        out << setw(16) << setprecision(2) << max_thread_ns[p] / 1e6 << endl;
+    }
+    out << "(sort and split_scoring are part of split_search; all phases nest in tree_fit)" << endl;
+    out.unsetf(ios::fixed);
+}
+
+void profiler::write_chrome_trace(const string& path) {
+    if (!is_enabled()) return;
+
+    ofstream out(path);
+    if (!out.is_open()) {
+        throw runtime_error("Could not open file for writing: " + path);
+    }
+
+    lock_guard<mutex> guard(registry_lock);
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+    for (const auto& profile : registry) {
+        for (const auto& event : profile->events) {
+            out << (first ? "" : ",\n")
+                << "{\"name\":\"" << PHASE_NAMES[(int)event.phase] << "\",\"ph\":\"X\",\"pid\":1"
+                << ",\"tid\":" << profile->thread_id
+                << ",\"ts\":" << fixed << setprecision(3) << event.start_ns / 1e3
+                << ",\"dur\":" << (event.end_ns - event.start_ns) / 1e3 << "}";
+            first = false;
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    if (!out) {
+        throw runtime_error("Failed writing trace: " + path);
+    }
+}
@@ -3,77 +3,130 @@ Progress tracking implementation for decision trees and random forests
 */
 
 #include "progress.hpp"
+#include <chrono>
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
+#include <cmath>
 
 using namespace std;
 
+// ==================== ProgressSlots Implementation ====================
+
+ProgressSlot& ProgressSlots::local() {
+    static atomic<int> next_index{0};
+    thread_local int index = next_index.fetch_add(1, memory_order_relaxed) % MAX_SLOTS;
+    return slots[index];
+}
+
+void ProgressSlots::reset() {
+    for (auto& slot : slots) {
+        slot.nodes_in_flight.store(0, memory_order_relaxed);
+        slot.trees_completed.store(0, memory_order_relaxed);
+    }
+}
+
+long long ProgressSlots::total_nodes_in_flight() const {
+    long long total = 0;
+    for (const auto& slot : slots) total += slot.nodes_in_flight.load(memory_order_relaxed);
+    return total;
+}
+
+int ProgressSlots::total_trees_completed() const {
+    int total = 0;
+    for (const auto& slot : slots) total += slot.trees_completed.load(memory_order_relaxed);
+    return total;
+}
+
 // ==================== TreeProgress Implementation ====================
 
-TreeProgress::TreeProgress() : nodes_created(0), estimated_total_nodes(100) {}
+TreeProgress::TreeProgress() : slots(nullptr), estimated_total_nodes(100) {}
 
 void TreeProgress::initialize(int max_depth, int min_samples_per_leaf, size_t n_samples) {
-    nodes_created = 0;
+    if (!slots) {
+        own_slots = make_unique<ProgressSlots>();
+        slots = own_slots.get();
+    } else if (slots == own_slots.get()) {
+        own_slots->reset();
+    }
     
-    if (max_depth == -1) {
-        // Unlimited depth - use sample-based estimate
-        // Heuristic: roughly n_samples / min_samples_per_leaf leaf nodes
-        // Total nodes ≈ 2 * num_leaves (since binary tree)
-        int estimated_leaves = max(1, (int)(n_samples / max(1, min_samples_per_leaf)));
-        estimated_total_nodes = max(10, 2 * estimated_leaves);
-    } else {
-        // Use depth-based estimate, but be generous for unbalanced trees
-        // For balanced tree: 2^(d+1) - 1 nodes
-        // For unbalanced trees (one-vs-rest categorical): multiply by factor
-        int balanced_estimate = (1 << (max_depth + 1)) - 1;  // 2^(d+1) - 1
-        estimated_total_nodes = max(10, (int)(balanced_estimate * 1.5));  // 50% buffer for imbalance
+    // Heuristic: roughly n_samples / min_samples_per_leaf leaf nodes
+    // Total nodes ≈ 2 * num_leaves (since binary tree)
+    long long estimated_leaves = max<long long>(1, n_samples / max(1, min_samples_per_leaf));
+    long long sample_estimate = 2 * estimated_leaves;
+    if (max_depth >= 0 && max_depth < 40) {
+        // A depth limit can only lower it: balanced tree has 2^(d+1) - 1 nodes,
+        // with a 50% buffer for unbalanced (one-vs-rest categorical) trees
+        long long balanced_estimate = (1LL << (max_depth + 1)) - 1;
+        sample_estimate = min(sample_estimate, (long long)(balanced_estimate * 1.5));
     }
+    estimated_total_nodes = max(10LL, sample_estimate);
+    nodes_counted.store(0, memory_order_relaxed);
 }
 
 void TreeProgress::increment_nodes() {
-    nodes_created++;
+    slots->local().nodes_in_flight.fetch_add(1, memory_order_relaxed);
+    nodes_counted.fetch_add(1, memory_order_relaxed);
 }
 
 double TreeProgress::get_progress() const {
-    int current = nodes_created.load();
+    if (!slots) return 0.0;
+    if (slots->total_trees_completed() > 0) return 1.0;
     // Cap at 99% until tree is complete (avoid showing 100% prematurely)
-    return min(0.99, current / (double)estimated_total_nodes);
+    return min(0.99, slots->total_nodes_in_flight() / (double)estimated_total_nodes);
 }
 
 void TreeProgress::mark_complete() {
-    // Set to estimated total to show 100%
-    nodes_created = estimated_total_nodes;
+    // Slots may go negative individually; their sum drops by exactly this tree's nodes
+    ProgressSlot& slot = slots->local();
+    slot.nodes_in_flight.fetch_sub(nodes_counted.exchange(0, memory_order_relaxed), memory_order_relaxed);
+    if (slots == own_slots.get()) {
+        slot.trees_completed.fetch_add(1, memory_order_relaxed);
+    }
 }
 
 // ==================== RandomForestProgress Implementation ====================
 
 RandomForestProgress::RandomForestProgress() 
-    : trees_completed(0), total_trees(0), tree_progresses(nullptr) {
-    omp_init_lock(&output_lock);
-}
+    : total_trees(0), estimated_total_nodes(0), tree_progresses(nullptr) {}
 
 RandomForestProgress::~RandomForestProgress() {
-    omp_destroy_lock(&output_lock);
+    stop_reporter();
     if (tree_progresses) {
         delete[] tree_progresses;
     }
 }
 
 void RandomForestProgress::initialize(int num_trees) {
-    trees_completed = 0;
+    stop_reporter();
+    
     total_trees = num_trees;
+    estimated_total_nodes = 0;
+    last_percent = -1;
+    slots.reset();
     
     if (tree_progresses) {
         delete[] tree_progresses;
     }
     tree_progresses = new TreeProgress[num_trees];
+    for (int i = 0; i < num_trees; i++) {
+        tree_progresses[i].slots = &slots;
+    }
+    
+    stop_requested = false;
+    reporter = thread([this] {
+        unique_lock<mutex> guard(reporter_lock);
+        while (!reporter_wake.wait_for(guard, chrono::milliseconds(report_interval_ms), [this] { return stop_requested; })) {
+            print_progress();
+        }
+    });
 }
 
 void RandomForestProgress::initialize_tree(int tree_idx, int max_depth, 
                                            int min_samples_per_leaf, size_t n_samples) {
     if (tree_idx >= 0 && tree_idx < total_trees) {
         tree_progresses[tree_idx].initialize(max_depth, min_samples_per_leaf, n_samples);
+        estimated_total_nodes += tree_progresses[tree_idx].estimated_total_nodes;
     }
 }
 
@@ -85,45 +138,31 @@ void RandomForestProgress::increment_tree_nodes(int tree_idx) {
 
 void RandomForestProgress::mark_tree_complete(int tree_idx) {
     if (tree_idx >= 0 && tree_idx < total_trees) {
-        tree_progresses[tree_idx].mark_complete();
-        trees_completed++;
+        slots.local().trees_completed.fetch_add(1, memory_order_relaxed);
     }
 }
 
 double RandomForestProgress::get_overall_progress() const {
     if (total_trees == 0) return 0.0;
     
-    double total_progress = 0.0;
-    int completed = trees_completed.load();
-    
-    // Add progress from completed trees
-    total_progress += completed;
-    
-    // Add progress from in-progress trees
-    for (int i = 0; i < total_trees; i++) {
-        if (tree_progresses[i].nodes_created.load() > 0 && 
-            tree_progresses[i].nodes_created.load() < tree_progresses[i].estimated_total_nodes) {
-            total_progress += tree_progresses[i].get_progress();
-        }
-    }
-    
-    return total_progress / total_trees;
+    // Completed trees count fully; in-flight nodes count as a fraction of a tree
+    int completed = min(total_trees, slots.total_trees_completed());
+    double nodes_per_tree = max(1.0, estimated_total_nodes / (double)total_trees);
+    double in_flight = min(0.99 * (total_trees - completed), slots.total_nodes_in_flight() / nodes_per_tree);
+    return (completed + in_flight) / total_trees;
 }
 
 void RandomForestProgress::print_progress(bool force_print) {
-    static int last_percent = -1;
-    
-    int current_percent = (int)(get_overall_progress() * 100);
+    double progress = get_overall_progress();
+    int current_percent = (int)(progress * 100);
     
     // Only print when percentage changes (reduce console spam) or forced
     if (force_print || current_percent != last_percent) {
-        omp_set_lock(&output_lock);
-        
-        int completed = trees_completed.load();
+        int completed = slots.total_trees_completed();
         cout << "\rTraining Progress: [";
         
         // Progress bar (50 characters wide)
-        int filled = (int)(get_overall_progress() * 50);
+        int filled = (int)(progress * 50);
         for (int i = 0; i < 50; i++) {
             if (i < filled) cout << "█";
             else cout << "░";
@@ -133,16 +172,22 @@ void RandomForestProgress::print_progress(bool force_print) {
              << completed << "/" << total_trees << " trees)" << flush;
         
         last_percent = current_percent;
-        
-        omp_unset_lock(&output_lock);
     }
 }
 
+void RandomForestProgress::stop_reporter() {
+    if (!reporter.joinable()) return;
+    {
+        lock_guard<mutex> guard(reporter_lock);
+        stop_requested = true;
+    }
+    reporter_wake.notify_one();
+    reporter.join();
+}
+
 void RandomForestProgress::finish() {
-    omp_set_lock(&output_lock);
+    stop_reporter();
     cout << "\rTraining Progress: [";
     for (int i = 0; i < 50; i++) cout << "█";
     cout << "] 100% (" << total_trees << "/" << total_trees << " trees)\n";
-    omp_unset_lock(&output_lock);
 }
-
@@ -3,13 +3,26 @@ Random Forest implementation with parallel training and prediction
 */
 
 #include "random_forest.hpp"
+#include "columnar.hpp"
+#include "binary_io.hpp"
+#include "profiler.hpp"
+#include "metrics_registry.hpp"
 #include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <numeric>
 #include <random>
+#include <set>
 #include <stdexcept>
 #include <omp.h>
 
 using namespace std;
 
+// Shared with flat_forest, which counts the rows it scores itself
+static metric_counter& rows_scored = metrics_registry::global().get_counter(
+    "prf_rows_scored_total", "Rows evaluated by a forest (predict and predict_proba each count)");
+
 // Generate bootstrap sample (sampling with replacement)
 vector<size_t> random_forest::generate_bootstrap_sample(
     size_t n_samples,
@@ -29,11 +42,21 @@ vector<size_t> random_forest::generate_bootstrap_sample(
     return bootstrap_indices;
 }
 
+// Bootstrap sample size, honoring the optional per-tree cap
+size_t random_forest::bootstrap_size(size_t n_samples) const {
+    size_t sample_size = static_cast<size_t>(n_samples * rf_config->bootstrap_sample_ratio);
+    if (rf_config->max_samples_per_tree > 0) {
+        sample_size = min(sample_size, rf_config->max_samples_per_tree);
+    }
+    return sample_size;
+}
+
 // Training
 void random_forest::fit(
     const data_frame& df,
     const vector<string>& feature_cols,
-    const string& target_col
+    const string& target_col,
+    const vector<size_t>* row_indices
 ) {
     if (!rf_config) {
         throw runtime_error("random_forest_config not set. Set rf_config before calling fit().");
@@ -50,79 +73,202 @@ void random_forest::fit(
             const_cast<string_col*>(str_target)->fit_encoding();
         }
         num_classes = str_target->num_unique_values();
+        
+        class_labels.clear();
+        for (int c = 0; c < num_classes; ++c) {
+            class_labels.push_back(str_target->decode(c));
+        }
     } else if (auto int_target = dynamic_cast<const int_col*>(target_column)) {
         const auto& data = int_target->get_data();
         num_classes = *max_element(data.begin(), data.end()) + 1;
+        class_labels.clear();
+    } else if (dynamic_cast<const float_col*>(target_column)) {
+        num_classes = 1;
+        class_labels.clear();
     } else {
-        throw invalid_argument("Target column must be string or int type");
+        throw invalid_argument("Target column must be string, int or float type");
     }
+    regression = dynamic_cast<const float_col*>(target_column) != nullptr;
     
-    // Resize trees vector
-    int num_trees = rf_config->num_trees;
+    feature_names = feature_cols;
+    target_column_name = target_col;
+    
+    feature_types.clear();
+    feature_categories.clear();
+    for (const auto& name : feature_cols) {
+        const col* feature_column = df.get_column(name);
+        if (!feature_column) {
+            throw invalid_argument("Feature column not found: " + name);
+        }
+        feature_types.push_back(feature_column->get_type());
+        
+        // Category list without touching the column's own (non-thread-safe) encoding
+        vector<string> categories;
+        if (auto str_feature = dynamic_cast<const string_col*>(feature_column)) {
+            set<string> unique_values(str_feature->get_data().begin(), str_feature->get_data().end());
+            categories.assign(unique_values.begin(), unique_values.end());
+        }
+        feature_categories.push_back(categories);
+    }
+    
+    // Weights are checked here, where errors can still propagate
+    if (growing_config && !growing_config->weight_column.empty()) {
+        if (!(check_row_weights(df, row_indices) > 0.0)) {
+            throw invalid_argument("Sample weights of the training rows are all zero: " + growing_config->weight_column);
+        }
+    } else {
+        check_weighting("");
+    }
+    
+    // Start from an empty forest
+    trees.clear();
+    train_trees(df, rf_config->num_trees, row_indices);
+}
+
+double random_forest::check_row_weights(const data_frame& df, const vector<size_t>* row_indices, size_t first_row) const {
+    const string& weight_name = growing_config->weight_column;
+    const col* weight_column = df.get_column(weight_name);
+    if (!weight_column) {
+        throw invalid_argument("Sample weight column not found: " + weight_name);
+    }
+    check_weighting(weight_column->get_type());
+    
+    auto int_weights = dynamic_cast<const int_col*>(weight_column);
+    auto float_weights = dynamic_cast<const float_col*>(weight_column);
+    size_t n_rows = row_indices ? row_indices->size() : df.get_num_rows();
+    double total = 0.0;
+    for (size_t i = 0; i < n_rows; ++i) {
+        size_t r = row_indices ? (*row_indices)[i] : i;
+        if (int_weights ? int_weights->is_missing(r) : float_weights->is_missing(r)) {
+            throw invalid_argument("Sample weight column has missing values: " + weight_name);
+        }
+        double weight = int_weights ? int_weights->get(r) : float_weights->get(r);
+        if (!(weight >= 0.0) || isinf(weight)) {
+            throw invalid_argument("Sample weights must be finite and non-negative (" + weight_name + ", row " +
+                                   to_string(first_row + r) + ")");
+        }
+        total += weight;
+    }
+    return total;
+}
+
+void random_forest::check_weighting(const string& weight_type) const {
+    if (!growing_config) return;
+    
+    if (!growing_config->weight_column.empty() && weight_type != "int" && weight_type != "float") {
+        throw invalid_argument("Sample weight column must be a numeric column: " + growing_config->weight_column);
+    }
+    
+    const vector<double>& class_weights = growing_config->class_weights;
+    if (regression || growing_config->balance_classes || class_weights.empty()) return;
+    if ((int)class_weights.size() != num_classes) {
+        throw invalid_argument("Expected " + to_string(num_classes) + " class weights, got " + to_string(class_weights.size()));
+    }
+    for (double weight : class_weights) {
+        if (!(weight >= 0.0)) throw invalid_argument("Class weights must be non-negative");
+    }
+}
+
+// Warm start: grow an already-fitted forest
+void random_forest::add_trees(
+    const data_frame& df,
+    int num_new_trees,
+    const vector<size_t>* row_indices
+) {
+    if (trees.empty()) {
+        throw runtime_error("Forest not fitted. Call fit() first.");
+    }
+    if (!rf_config) {
+        throw runtime_error("random_forest_config not set. Set rf_config before calling add_trees().");
+    }
+    
+    train_trees(df, num_new_trees, row_indices);
+}
+
+// Helper: Train num_new_trees trees and append them to the forest.
+// Tree i always uses seed random_seed + i, so fit(n) followed by add_trees(m)
+// yields the same forest as fit(n + m).
+void random_forest::train_trees(
+    const data_frame& df,
+    int num_new_trees,
+    const vector<size_t>* row_indices
+) {
+    if (num_new_trees <= 0) return;
+    
+    int first_tree = trees.size();
+    int num_trees = first_tree + num_new_trees;
     trees.resize(num_trees);
     
     // Calculate bootstrap sample size
-    size_t n_samples = df.get_num_rows();
-    size_t sample_size = static_cast<size_t>(n_samples * rf_config->bootstrap_sample_ratio);
+    size_t n_samples = row_indices ? row_indices->size() : df.get_num_rows();
+    size_t sample_size = bootstrap_size(n_samples);
     
-    // Generate all bootstrap samples (sequential - fast enough)
-    vector<vector<size_t>> bootstrap_samples(num_trees);
-    for (int i = 0; i < num_trees; ++i) {
+    // Generate bootstrap samples of the new trees (sequential - fast enough)
+    vector<vector<size_t>> bootstrap_samples(num_new_trees);
+    for (int i = 0; i < num_new_trees; ++i) {
+        PRF_PROFILE_SCOPE(BOOTSTRAP);
         bootstrap_samples[i] = generate_bootstrap_sample(
             n_samples,
             sample_size,
-            rf_config->random_seed + i
+            rf_config->random_seed + first_tree + i
         );
+        
+        // Map sample positions back onto the caller's row subset
+        if (row_indices) {
+            for (size_t& idx : bootstrap_samples[i]) {
+                idx = (*row_indices)[idx];
+            }
+        }
     }
     
     // Initialize progress tracker if provided
     if (progress_tracker) {
-        progress_tracker->initialize(num_trees);
+        progress_tracker->initialize(num_new_trees);
         
         // Initialize each tree's progress tracker
         int max_d = (hp_config ? hp_config->max_depth : -1);
         int min_samples = (hp_config ? hp_config->min_examples_per_leaf : 1);
-        for (int i = 0; i < num_trees; ++i) {
+        for (int i = 0; i < num_new_trees; ++i) {
             progress_tracker->initialize_tree(i, max_d, min_samples, sample_size);
         }
     }
     
-    // Train all trees (parallel or sequential based on config)
+    // Train new trees (parallel or sequential based on config)
     if (rf_config->use_parallel) {
         #pragma omp parallel for
-        for (int i = 0; i < num_trees; ++i) {
-            trees[i].hp_config = hp_config;
-            trees[i].growing_config = growing_config;
+        for (int i = 0; i < num_new_trees; ++i) {
+            decision_tree& tree = trees[first_tree + i];
+            tree.hp_config = hp_config;
+            tree.growing_config = growing_config;
             
             // Link tree to its progress tracker
             if (progress_tracker) {
-                trees[i].progress_tracker = &(progress_tracker->tree_progresses[i]);
+                tree.progress_tracker = &(progress_tracker->tree_progresses[i]);
             }
             
-            trees[i].fit(df, feature_cols, target_col, &bootstrap_samples[i]);
+            tree.fit(df, feature_names, target_column_name, &bootstrap_samples[i]);
             
-            // Mark tree complete and update display
+            // Mark tree complete (the tracker's reporter thread draws the bar)
             if (progress_tracker) {
                 progress_tracker->mark_tree_complete(i);
-                progress_tracker->print_progress();
             }
         }
     } else {
-        for (int i = 0; i < num_trees; ++i) {
-            trees[i].hp_config = hp_config;
-            trees[i].growing_config = growing_config;
+        for (int i = 0; i < num_new_trees; ++i) {
+            decision_tree& tree = trees[first_tree + i];
+            tree.hp_config = hp_config;
+            tree.growing_config = growing_config;
             
             // Link tree to its progress tracker
             if (progress_tracker) {
-                trees[i].progress_tracker = &(progress_tracker->tree_progresses[i]);
+                tree.progress_tracker = &(progress_tracker->tree_progresses[i]);
             }
             
-            trees[i].fit(df, feature_cols, target_col, &bootstrap_samples[i]);
+            tree.fit(df, feature_names, target_column_name, &bootstrap_samples[i]);
             
-            // Mark tree complete and update display
+            // Mark tree complete (the tracker's reporter thread draws the bar)
             if (progress_tracker) {
                 progress_tracker->mark_tree_complete(i);
-                progress_tracker->print_progress();
             }
         }
     }
@@ -131,16 +277,631 @@ void random_forest::fit(
     if (progress_tracker) {
         progress_tracker->finish();
     }
+    
+    // Flatten the new trees for single-row inference
+    if (first_tree == 0) {
+        compiled.reset(num_classes, feature_categories);
+    }
+    for (int i = first_tree; i < num_trees; ++i) {
+        compiled.append_tree(trees[i]);
+    }
+    update_importances();
+}
+
+// Out-of-core training from a memory-mapped columnar file
+void random_forest::fit_out_of_core(
+    const columnar_file& file,
+    const vector<string>& feature_cols,
+    const string& target_col
+) {
+    if (!rf_config) {
+        throw runtime_error("random_forest_config not set. Set rf_config before calling fit_out_of_core().");
+    }
+    
+    // Class count of the whole file, so every tree agrees on it
+    regression = file.get_column_type(target_col) == "float";
+    num_classes = regression ? 1 : file.count_classes(target_col);
+    feature_names = feature_cols;
+    target_column_name = target_col;
+    
+    feature_types.clear();
+    feature_categories.clear();
+    for (const auto& name : feature_cols) {
+        feature_types.push_back(file.get_column_type(name));
+        feature_categories.push_back(feature_types.back() == "string" ? file.get_categories(name) : vector<string>());
+    }
+    
+    class_labels.clear();
+    if (file.get_column_type(target_col) == "string") {
+        class_labels = file.get_categories(target_col);
+    }
+    
+    vector<string> needed_columns = feature_cols;
+    needed_columns.push_back(target_col);
+    if (growing_config && !growing_config->weight_column.empty()) {
+        // Only the weight column is read for the check, a fixed number of rows at a time
+        const string& weight_name = growing_config->weight_column;
+        check_weighting(file.get_column_type(weight_name));
+        const size_t chunk_rows = 65536;
+        double total_weight = 0.0;
+        vector<size_t> chunk;
+        for (size_t start = 0; start < file.get_num_rows(); start += chunk_rows) {
+            chunk.resize(min(chunk_rows, file.get_num_rows() - start));
+            iota(chunk.begin(), chunk.end(), start);
+            total_weight += check_row_weights(file.materialize(chunk, {weight_name}), nullptr, start);
+        }
+        if (!(total_weight > 0.0)) {
+            throw invalid_argument("Sample weights of the training rows are all zero: " + weight_name);
+        }
+        needed_columns.push_back(weight_name);
+    } else {
+        check_weighting("");
+    }
+    
+    int num_trees = rf_config->num_trees;
+    size_t n_samples = file.get_num_rows();
+    size_t sample_size = bootstrap_size(n_samples);
+    
+    trees.clear();
+    trees.resize(num_trees);
+    
+    // Initialize progress tracker if provided
+    if (progress_tracker) {
+        progress_tracker->initialize(num_trees);
+        
+        int max_d = (hp_config ? hp_config->max_depth : -1);
+        int min_samples = (hp_config ? hp_config->min_examples_per_leaf : 1);
+        for (int i = 0; i < num_trees; ++i) {
+            progress_tracker->initialize_tree(i, max_d, min_samples, sample_size);
+        }
+    }
+    
+    #pragma omp parallel for schedule(dynamic, 1) if(rf_config->use_parallel)
+    for (int i = 0; i < num_trees; ++i) {
+        // Sorted bootstrap -> one forward sweep over every mapped column
+        vector<size_t> bootstrap = generate_bootstrap_sample(n_samples, sample_size, rf_config->random_seed + i);
+        sort(bootstrap.begin(), bootstrap.end());
+        data_frame sample = file.materialize(bootstrap, needed_columns);
+        
+        decision_tree& tree = trees[i];
+        tree.hp_config = hp_config;
+        tree.growing_config = growing_config;
+        tree.min_num_classes = num_classes;
+        
+        if (progress_tracker) {
+            tree.progress_tracker = &(progress_tracker->tree_progresses[i]);
+        }
+        
+        tree.fit(sample, feature_names, target_column_name);
+        
+        if (progress_tracker) {
+            progress_tracker->mark_tree_complete(i);
+        }
+    }
+    
+    if (progress_tracker) {
+        progress_tracker->finish();
+    }
+    
+    // Flatten for single-row inference
+    compiled.reset(num_classes, feature_categories);
+    for (const auto& tree : trees) {
+        compiled.append_tree(tree);
+    }
+    update_importances();
+}
+
+// Helper: Average the trees' normalized importances (single-leaf trees count as all zero)
+void random_forest::update_importances() {
+    impurity_importances.assign(feature_names.size(), 0.0);
+    for (const auto& tree : trees) {
+        const vector<double>& importances = tree.get_feature_importances();
+        for (size_t f = 0; f < importances.size(); ++f) {
+            impurity_importances[f] += importances[f] / trees.size();
+        }
+    }
+}
+
+int random_forest::get_num_trees() const {
+    return compiled.get_num_trees();
+}
+
+compact_forest random_forest::compact() const {
+    if (regression) {
+        throw runtime_error("The compact variant stores probabilities in [0, 1]; not available for regression");
+    }
+    compact_forest model;
+    model.build(compiled);
+    return model;
+}
+
+// Helper: Target classes in this forest's encoding (-1 = label unknown to the forest)
+vector<int> random_forest::target_classes(const data_frame& X) const {
+    vector<int> labels;
+    if (const col* target = X.get_column(target_column_name)) {
+        for (size_t r = 0; r < X.get_num_rows(); ++r) {
+            if (auto str_target = dynamic_cast<const string_col*>(target)) {
+                auto it = find(class_labels.begin(), class_labels.end(), str_target->get(r));
+                labels.push_back(it == class_labels.end() ? -1 : it - class_labels.begin());
+            } else if (auto int_target = dynamic_cast<const int_col*>(target)) {
+                labels.push_back(int_target->is_missing(r) ? -1 : int_target->get(r));
+            }
+        }
+    }
+    return labels;
+}
+
+// Helper: Regression targets of X's rows
+vector<double> random_forest::target_values(const data_frame& X) const {
+    vector<double> values;
+    if (auto target = dynamic_cast<const float_col*>(X.get_column(target_column_name))) {
+        values = target->get_data();
+    } else if (auto int_target = dynamic_cast<const int_col*>(X.get_column(target_column_name))) {
+        values.assign(int_target->get_data().begin(), int_target->get_data().end());
+    }
+    return values;
+}
+
+compact_check random_forest::check_compact(const compact_forest& model, const data_frame& X) const {
+    if (compiled.empty() || model.get_num_classes() != num_classes) {
+        throw runtime_error("Compact model does not belong to this forest");
+    }
+    
+    vector<size_t> all_rows(X.get_num_rows());
+    iota(all_rows.begin(), all_rows.end(), 0);
+    vector<double> dense = gather_dense_rows(X, all_rows);
+    size_t n_features = feature_names.size();
+    
+    vector<int> labels = target_classes(X);
+    
+    compact_check check;
+    check.rows = all_rows.size();
+    check.full_bytes = compiled.memory_bytes();
+    check.compact_bytes = model.memory_bytes();
+    
+    size_t full_correct = 0, compact_correct = 0;
+    vector<double> full_proba(num_classes), compact_proba(num_classes);
+    for (size_t r = 0; r < all_rows.size(); ++r) {
+        int full_class = compiled.predict_row(dense.data() + r * n_features, full_proba.data());
+        int compact_class = model.predict_row(dense.data() + r * n_features, compact_proba.data());
+        
+        if (full_class != compact_class) check.class_mismatches++;
+        for (int c = 0; c < num_classes; ++c) {
+            check.max_probability_error = max(check.max_probability_error, fabs(full_proba[c] - compact_proba[c]));
+        }
+        if (!labels.empty()) {
+            full_correct += (full_class == labels[r]);
+            compact_correct += (compact_class == labels[r]);
+        }
+    }
+    
+    if (!labels.empty() && check.rows > 0) {
+        check.full_accuracy = (double)full_correct / check.rows;
+        check.compact_accuracy = (double)compact_correct / check.rows;
+    }
+    return check;
+}
+
+void random_forest::export_cpp(const string& path, const string& name) const {
+    ofstream out(path, ios::trunc);
+    if (!out.is_open()) {
+        throw runtime_error("Could not open file for writing: " + path);
+    }
+    
+    vector<string> labels;
+    for (int c = 0; c < num_classes; ++c) labels.push_back(get_class_label(c));
+    compiled.export_cpp(out, name, feature_names, labels);
+    
+    if (!out) {
+        throw runtime_error("Failed writing generated scorer: " + path);
+    }
+}
+
+// Regression prediction: the flattened forest's averaged single "probability"
+vector<double> random_forest::predict_values(const data_frame& X) const {
+    if (compiled.empty()) {
+        throw runtime_error("Forest not fitted. Call fit() first.");
+    }
+    if (!regression) {
+        throw runtime_error("predict_values needs a regression forest (float target); use predict");
+    }
+    
+    vector<size_t> all_rows(X.get_num_rows());
+    iota(all_rows.begin(), all_rows.end(), 0);
+    vector<double> dense = gather_dense_rows(X, all_rows);
+    vector<double> values(all_rows.size());
+    size_t n_features = feature_names.size();
+    
+    const size_t block = 256;
+    size_t n_blocks = (all_rows.size() + block - 1) / block;
+    
+    #pragma omp parallel if(rf_config && rf_config->use_parallel)
+    {
+        vector<int> classes(block);
+        #pragma omp for
+        for (size_t b = 0; b < n_blocks; ++b) {
+            size_t start = b * block;
+            size_t count = min(block, all_rows.size() - start);
+            compiled.predict_rows(dense.data() + start * n_features, count, n_features,
+                                  classes.data(), values.data() + start);
+        }
+    }
+    return values;
+}
+
+// ==================== Model Files ====================
+
+static const char MODEL_MAGIC[8] = {'P', 'R', 'F', 'M', 'D', 'L', '1', '\0'};
+
+void random_forest::save(const string& path) const {
+    if (compiled.empty()) {
+        throw runtime_error("Forest not fitted. Call fit() first.");
+    }
+    
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out.is_open()) {
+        throw runtime_error("Could not open file for writing: " + path);
+    }
+    
+    out.write(MODEL_MAGIC, sizeof(MODEL_MAGIC));
+    write_pod(out, (int32_t)num_classes);
+    write_string(out, target_column_name);
+    
+    write_pod(out, (uint32_t)feature_names.size());
+    for (size_t f = 0; f < feature_names.size(); ++f) {
+        write_string(out, feature_names[f]);
+        write_string(out, feature_types[f]);
+    }
+    
+    write_pod(out, (uint32_t)class_labels.size());
+    for (const auto& label : class_labels) write_string(out, label);
+    
+    compiled.write(out);
+    
+    // Trailing sections (absent in older model files)
+    write_pod(out, (uint32_t)impurity_importances.size());
+    for (double importance : impurity_importances) write_pod(out, importance);
+    write_pod(out, (uint8_t)regression);
+    
+    if (!out) {
+        throw runtime_error("Failed writing model file: " + path);
+    }
+}
+
+random_forest random_forest::load(const string& path) {
+    ifstream in(path, ios::binary);
+    if (!in.is_open()) {
+        throw runtime_error("Could not open file: " + path);
+    }
+    
+    char magic[sizeof(MODEL_MAGIC)];
+    if (!in.read(magic, sizeof(magic)) || !equal(magic, magic + sizeof(magic), MODEL_MAGIC)) {
+        throw runtime_error("Not a random forest model file: " + path);
+    }
+    
+    random_forest forest;
+    forest.num_classes = read_pod<int32_t>(in);
+    forest.target_column_name = read_string(in);
+    
+    uint32_t num_features = read_pod<uint32_t>(in);
+    for (uint32_t f = 0; f < num_features; ++f) {
+        forest.feature_names.push_back(read_string(in));
+        forest.feature_types.push_back(read_string(in));
+    }
+    
+    uint32_t num_labels = read_pod<uint32_t>(in);
+    for (uint32_t c = 0; c < num_labels; ++c) {
+        forest.class_labels.push_back(read_string(in));
+    }
+    
+    forest.compiled.read(in);
+    if (forest.compiled.get_num_classes() != forest.num_classes) {
+        throw runtime_error("Corrupt model file: class count mismatch in " + path);
+    }
+    // Node feature indices are only checked against the flat forest's own count; rows
+    // are gathered with one value per named feature
+    if (forest.compiled.get_num_features() != (int)num_features) {
+        throw runtime_error("Corrupt model file: feature count mismatch in " + path);
+    }
+    
+    if (in.peek() != char_traits<char>::eof()) {
+        uint32_t num_importances = read_pod<uint32_t>(in);
+        if (num_importances != 0 && num_importances != num_features) {
+            throw runtime_error("Corrupt model file: feature importance count mismatch in " + path);
+        }
+        for (uint32_t f = 0; f < num_importances; ++f) {
+            forest.impurity_importances.push_back(read_pod<double>(in));
+        }
+    }
+    if (in.peek() != char_traits<char>::eof()) {
+        forest.regression = read_pod<uint8_t>(in) != 0;
+        if (forest.regression && forest.num_classes != 1) {
+            throw runtime_error("Corrupt model file: regression model with " + to_string(forest.num_classes) + " classes in " + path);
+        }
+    }
+    
+    return forest;
+}
+
+bool random_forest::is_regressor() const {
+    return regression;
+}
+
+int random_forest::get_num_classes() const {
+    return num_classes;
+}
+
+const vector<string>& random_forest::get_feature_names() const {
+    return feature_names;
+}
+
+const vector<string>& random_forest::get_feature_types() const {
+    return feature_types;
+}
+
+string random_forest::get_class_label(int class_idx) const {
+    if (class_labels.empty()) {
+        return to_string(class_idx);
+    }
+    if (class_idx < 0 || class_idx >= (int)class_labels.size()) {
+        throw out_of_range("Class index out of range: " + to_string(class_idx));
+    }
+    return class_labels[class_idx];
+}
+
+const vector<double>& random_forest::feature_importances() const {
+    if (compiled.empty()) {
+        throw runtime_error("Forest not fitted. Call fit() first.");
+    }
+    return impurity_importances;
+}
+
+// Permutation importance: one task per (feature, repeat), all reading the same dense rows
+permutation_result random_forest::permutation_importance(const data_frame& X, int num_repeats, unsigned int seed) const {
+    if (compiled.empty()) {
+        throw runtime_error("Forest not fitted. Call fit() first.");
+    }
+    if (num_repeats < 1) {
+        throw invalid_argument("num_repeats must be >= 1");
+    }
+    
+    vector<int> labels;
+    vector<double> values;
+    if (regression) {
+        values = target_values(X);
+    } else {
+        labels = target_classes(X);
+    }
+    if (labels.empty() && values.empty()) {
+        throw invalid_argument("Permutation importance needs the target column: " + target_column_name);
+    }
+    
+    // Rows with a missing target are left out
+    vector<size_t> scored_rows;
+    for (size_t r = 0; r < X.get_num_rows(); ++r) {
+        if (regression ? std::isnan(values[r]) : labels[r] < 0) continue;
+        if (regression) {
+            values[scored_rows.size()] = values[r];
+        } else {
+            labels[scored_rows.size()] = labels[r];
+        }
+        scored_rows.push_back(r);
+    }
+    values.resize(regression ? scored_rows.size() : 0);
+    labels.resize(regression ? 0 : scored_rows.size());
+    
+    size_t n_rows = scored_rows.size();
+    size_t n_features = feature_names.size();
+    vector<size_t> all_rows(n_rows);
+    iota(all_rows.begin(), all_rows.end(), 0);
+    vector<double> dense = gather_dense_rows(X, scored_rows);
+    
+    // Regression: R^2 = 1 - squared error / total sum of squares about the mean
+    double total_squares = 0.0;
+    if (regression) {
+        double mean = accumulate(values.begin(), values.end(), 0.0) / n_rows;
+        for (double value : values) total_squares += (value - mean) * (value - mean);
+    }
+    
+    // Accuracy / R^2 with feature f read from row order[r] instead of r (f < 0: unpermuted)
+    const size_t block = 256;
+    auto score = [&](int feature, const vector<size_t>* order) {
+        vector<double> rows(block * n_features);
+        vector<int> classes(block);
+        vector<double> probabilities(block * num_classes);
+        double correct = 0.0, squared_error = 0.0;
+        for (size_t start = 0; start < n_rows; start += block) {
+            size_t count = min(block, n_rows - start);
+            copy(dense.begin() + start * n_features, dense.begin() + (start + count) * n_features, rows.begin());
+            if (order) {
+                for (size_t r = 0; r < count; ++r) {
+                    rows[r * n_features + feature] = dense[(*order)[start + r] * n_features + feature];
+                }
+            }
+            compiled.predict_rows(rows.data(), count, n_features, classes.data(), probabilities.data());
+            for (size_t r = 0; r < count; ++r) {
+                if (regression) {
+                    double error = probabilities[r] - values[start + r];
+                    squared_error += error * error;
+                } else {
+                    correct += (classes[r] == labels[start + r]);
+                }
+            }
+        }
+        if (!regression) return correct / n_rows;
+        return total_squares > 0.0 ? 1.0 - squared_error / total_squares : 0.0;
+    };
+    
+    permutation_result result;
+    result.rows = n_rows;
+    result.num_repeats = num_repeats;
+    result.baseline_score = score(-1, nullptr);
+    
+    // decreases[f * num_repeats + k]; every (feature, repeat) draws its own permutation
+    // from (seed, f, k), so repeats and features are independent yet reproducible
+    int num_tasks = n_features * num_repeats;
+    vector<double> decreases(num_tasks);
+    
+    #pragma omp parallel for schedule(dynamic, 1) if(rf_config && rf_config->use_parallel)
+    for (int task = 0; task < num_tasks; ++task) {
+        int feature = task / num_repeats;
+        int repeat = task % num_repeats;
+        
+        vector<size_t> order(all_rows);
+        seed_seq task_seed{seed, (unsigned int)feature, (unsigned int)repeat};
+        mt19937 rng(task_seed);
+        shuffle(order.begin(), order.end(), rng);
+        
+        decreases[task] = result.baseline_score - score(feature, &order);
+    }
+    
+    result.mean_decrease.assign(n_features, 0.0);
+    result.stddev_decrease.assign(n_features, 0.0);
+    for (size_t f = 0; f < n_features; ++f) {
+        const double* values = decreases.data() + f * num_repeats;
+        double mean = accumulate(values, values + num_repeats, 0.0) / num_repeats;
+        double squares = 0.0;
+        for (int k = 0; k < num_repeats; ++k) squares += (values[k] - mean) * (values[k] - mean);
+        result.mean_decrease[f] = mean;
+        result.stddev_decrease[f] = num_repeats > 1 ? sqrt(squares / (num_repeats - 1)) : 0.0;
+    }
+    return result;
+}
+
+// Out-of-bag accuracy: every row is scored only by the trees whose bootstrap missed it
+double random_forest::oob_accuracy(const data_frame& df, const vector<size_t>* row_indices) const {
+    if (trees.empty()) {
+        throw runtime_error("Forest not fitted. Call fit() first.");
+    }
+    if (regression) {
+        throw runtime_error("oob_accuracy needs a classification forest");
+    }
+    
+    size_t n_samples = row_indices ? row_indices->size() : df.get_num_rows();
+    size_t sample_size = bootstrap_size(n_samples);
+    int num_trees = trees.size();
+    
+    // votes[pos * num_classes + c]: OOB votes for class c at sample position pos
+    vector<int> votes(n_samples * num_classes, 0);
+    
+    #pragma omp parallel for if(rf_config->use_parallel)
+    for (int i = 0; i < num_trees; ++i) {
+        // Regenerate the tree's bootstrap from its seed
+        vector<size_t> in_bag = generate_bootstrap_sample(n_samples, sample_size, rf_config->random_seed + i);
+        vector<char> is_in_bag(n_samples, 0);
+        for (size_t pos : in_bag) is_in_bag[pos] = 1;
+        
+        vector<size_t> oob_positions, oob_rows;
+        for (size_t pos = 0; pos < n_samples; ++pos) {
+            if (!is_in_bag[pos]) {
+                oob_positions.push_back(pos);
+                oob_rows.push_back(row_indices ? (*row_indices)[pos] : pos);
+            }
+        }
+        if (oob_rows.empty()) continue;
+        
+        vector<int> predictions = trees[i].predict(df, oob_rows);
+        for (size_t j = 0; j < oob_rows.size(); ++j) {
+            if (predictions[j] >= 0 && predictions[j] < num_classes) {
+                #pragma omp atomic
+                votes[oob_positions[j] * num_classes + predictions[j]]++;
+            }
+        }
+    }
+    
+    // Compare majority OOB vote against the target
+    const col* target_column = df.get_column(target_column_name);
+    auto str_target = dynamic_cast<const string_col*>(target_column);
+    auto int_target = dynamic_cast<const int_col*>(target_column);
+    
+    size_t scored = 0, correct = 0;
+    for (size_t pos = 0; pos < n_samples; ++pos) {
+        auto first = votes.begin() + pos * num_classes;
+        auto last = first + num_classes;
+        if (*max_element(first, last) == 0) continue;  // In-bag for every tree
+        
+        size_t row = row_indices ? (*row_indices)[pos] : pos;
+        if (int_target && int_target->is_missing(row)) continue;
+        int label = str_target ? str_target->get_encoded(row) : int_target->get(row);
+        int predicted = max_element(first, last) - first;
+        
+        scored++;
+        if (predicted == label) correct++;
+    }
+    
+    return scored > 0 ? static_cast<double>(correct) / scored : 0.0;
 }
 
 // Prediction via majority voting
 vector<int> random_forest::predict(const data_frame& X) const {
-    if (trees.empty()) {
+    vector<size_t> all_rows(X.get_num_rows());
+    iota(all_rows.begin(), all_rows.end(), 0);
+    return predict(X, all_rows);
+}
+
+// Helper: Dense, row-major copy of the requested rows in forest feature order
+vector<double> random_forest::gather_dense_rows(const data_frame& X, const vector<size_t>& row_indices) const {
+    size_t n_features = feature_names.size();
+    vector<double> dense(row_indices.size() * n_features);
+    
+    for (size_t f = 0; f < n_features; ++f) {
+        const col* column = X.get_column(feature_names[f]);
+        if (!column) {
+            throw invalid_argument("Feature column not found: " + feature_names[f]);
+        }
+        
+        for (size_t r = 0; r < row_indices.size(); ++r) {
+            double& value = dense[r * n_features + f];
+            if (auto str_column = dynamic_cast<const string_col*>(column)) {
+                value = compiled.encode_category(f, str_column->get(row_indices[r]));
+            } else if (auto int_column = dynamic_cast<const int_col*>(column)) {
+                value = int_column->is_missing(row_indices[r]) ? numeric_limits<double>::quiet_NaN()
+                                                               : int_column->get(row_indices[r]);
+            } else if (auto float_column = dynamic_cast<const float_col*>(column)) {
+                value = float_column->get(row_indices[r]);
+            }
+        }
+    }
+    
+    return dense;
+}
+
+vector<int> random_forest::predict(const data_frame& X, const vector<size_t>& row_indices) const {
+    if (trees.empty() && compiled.empty()) {
         throw runtime_error("Forest not fitted. Call fit() first.");
     }
+    if (regression) {
+        throw runtime_error("Regression forest: use predict_values");
+    }
+    
+    // Every fitted or loaded forest is scored on the flattened trees; per-tree
+    // voting below is only a fallback for a forest that was never compiled
+    if (!compiled.empty()) {
+        vector<double> dense = gather_dense_rows(X, row_indices);
+        vector<int> predictions(row_indices.size());
+        size_t n_features = feature_names.size();
+        
+        // Blocks of rows so the batched (heap layout) path can kick in
+        const size_t block = 256;
+        size_t n_blocks = (row_indices.size() + block - 1) / block;
+        
+        #pragma omp parallel if(rf_config && rf_config->use_parallel)
+        {
+            vector<double> probabilities(block * num_classes);
+            #pragma omp for
+            for (size_t b = 0; b < n_blocks; ++b) {
+                size_t start = b * block;
+                size_t count = min(block, row_indices.size() - start);
+                compiled.predict_rows(dense.data() + start * n_features, count, n_features,
+                                      predictions.data() + start, probabilities.data());
+            }
+        }
+        return predictions;
+    }
     
     int num_trees = trees.size();
-    size_t n_samples = X.get_num_rows();
+    size_t n_samples = row_indices.size();
+    rows_scored.add(n_samples);
     
     // Get predictions from all trees
     vector<vector<int>> all_predictions(num_trees);
@@ -148,11 +909,11 @@ vector<int> random_forest::predict(const data_frame& X) const {
     if (rf_config && rf_config->use_parallel) {
         #pragma omp parallel for
         for (int i = 0; i < num_trees; ++i) {
-            all_predictions[i] = trees[i].predict(X);
+            all_predictions[i] = trees[i].predict(X, row_indices);
         }
     } else {
         for (int i = 0; i < num_trees; ++i) {
-            all_predictions[i] = trees[i].predict(X);
+            all_predictions[i] = trees[i].predict(X, row_indices);
         }
     }
     
@@ -195,63 +956,61 @@ vector<int> random_forest::predict(const data_frame& X) const {
     return final_predictions;
 }
 
-// Prediction probabilities - average across all trees
-vector<vector<double>> random_forest::predict_proba(const data_frame& X) const {
-    if (trees.empty()) {
+// Single-row prediction on the flattened forest (no parallel region)
+int random_forest::predict_row(const double* row, double* proba_out) const {
+    if (compiled.empty()) {
+        throw runtime_error("Forest not fitted. Call fit() first.");
+    }
+    return compiled.predict_row(row, proba_out);
+}
+
+void random_forest::predict_rows(const double* rows, size_t n_rows, int* classes_out, double* proba_out) const {
+    if (compiled.empty()) {
         throw runtime_error("Forest not fitted. Call fit() first.");
     }
     
-    int num_trees = trees.size();
-    size_t n_samples = X.get_num_rows();
-    
-    // Get probabilities from all trees
-    vector<vector<vector<double>>> all_probabilities(num_trees);
-    
-    if (rf_config && rf_config->use_parallel) {
-        #pragma omp parallel for
-        for (int i = 0; i < num_trees; ++i) {
-            all_probabilities[i] = trees[i].predict_proba(X);
-        }
-    } else {
-        for (int i = 0; i < num_trees; ++i) {
-            all_probabilities[i] = trees[i].predict_proba(X);
-        }
+    compiled.predict_rows(rows, n_rows, feature_names.size(), classes_out, proba_out);
+}
+
+double random_forest::encode_category(int feature_idx, const string& value) const {
+    return compiled.encode_category(feature_idx, value);
+}
+
+// Prediction probabilities - average across all trees (scored on the flattened,
+// leaf-pooled forest; same values as averaging decision_tree::predict_proba)
+vector<vector<double>> random_forest::predict_proba(const data_frame& X, vector<int>* classes) const {
+    if (compiled.empty()) {
+        throw runtime_error("Forest not fitted. Call fit() first.");
     }
     
-    // Average probabilities across trees
-    vector<vector<double>> final_probabilities(n_samples, vector<double>(num_classes, 0.0));
+    vector<size_t> all_rows(X.get_num_rows());
+    iota(all_rows.begin(), all_rows.end(), 0);
+    vector<double> dense = gather_dense_rows(X, all_rows);
+    vector<vector<double>> probabilities(all_rows.size(), vector<double>(num_classes));
+    size_t n_features = feature_names.size();
+    if (classes) classes->assign(all_rows.size(), 0);
     
-    if (rf_config && rf_config->use_parallel) {
-        #pragma omp parallel for
-        for (size_t row = 0; row < n_samples; ++row) {
-            // Sum probabilities from all trees
-            for (int tree_idx = 0; tree_idx < num_trees; ++tree_idx) {
-                for (int class_idx = 0; class_idx < num_classes; ++class_idx) {
-                    final_probabilities[row][class_idx] += all_probabilities[tree_idx][row][class_idx];
-                }
-            }
-            
-            // Average by dividing by number of trees
-            for (int class_idx = 0; class_idx < num_classes; ++class_idx) {
-                final_probabilities[row][class_idx] /= num_trees;
-            }
-        }
-    } else {
-        for (size_t row = 0; row < n_samples; ++row) {
-            // Sum probabilities from all trees
-            for (int tree_idx = 0; tree_idx < num_trees; ++tree_idx) {
-                for (int class_idx = 0; class_idx < num_classes; ++class_idx) {
-                    final_probabilities[row][class_idx] += all_probabilities[tree_idx][row][class_idx];
-                }
-            }
-            
-            // Average by dividing by number of trees
-            for (int class_idx = 0; class_idx < num_classes; ++class_idx) {
-                final_probabilities[row][class_idx] /= num_trees;
+    const size_t block = 256;
+    size_t n_blocks = (all_rows.size() + block - 1) / block;
+    
+    #pragma omp parallel if(rf_config && rf_config->use_parallel)
+    {
+        vector<int> block_classes(block);
+        vector<double> block_probabilities(block * num_classes);
+        #pragma omp for
+        for (size_t b = 0; b < n_blocks; ++b) {
+            size_t start = b * block;
+            size_t count = min(block, all_rows.size() - start);
+            compiled.predict_rows(dense.data() + start * n_features, count, n_features,
+                                  block_classes.data(), block_probabilities.data());
+            if (classes) copy(block_classes.begin(), block_classes.begin() + count, classes->begin() + start);
+            for (size_t r = 0; r < count; ++r) {
+                copy(block_probabilities.begin() + r * num_classes,
+                     block_probabilities.begin() + (r + 1) * num_classes,
+                     probabilities[start + r].begin());
             }
         }
     }
-    
-    return final_probabilities;
+    return probabilities;
 }
 
@@ -0,0 +1,178 @@
+/*
+Streaming batch prediction pipeline: parse -> predict -> write
+*/
+
+#include "scoring.hpp"
+#include "bounded_queue.hpp"
+#include "metrics_registry.hpp"
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+// Predictions of one block, in input row order
+struct scored_block {
+    vector<int> classes;
+    vector<vector<double>> probabilities;  // Empty unless write_probabilities
+    vector<double> values;                 // Regression forests instead of classes
+};
+
+static metric_gauge& parsed_queue_depth = metrics_registry::global().get_gauge(
+    "prf_scoring_parsed_queue_depth", "Parsed blocks waiting for prediction in the batch scorer");
+static metric_gauge& scored_queue_depth = metrics_registry::global().get_gauge(
+    "prf_scoring_scored_queue_depth", "Predicted blocks waiting to be written by the batch scorer");
+
+static double elapsed_ms(chrono::high_resolution_clock::time_point since) {
+    return chrono::duration<double, milli>(chrono::high_resolution_clock::now() - since).count();
+}
+
+scoring_stats batch_scorer::run(const string& input_csv, const string& output_path) const {
+    if (!forest || forest->get_num_trees() == 0) {
+        throw runtime_error("Forest not fitted. Set a fitted forest before calling run().");
+    }
+    if (!config) {
+        throw runtime_error("scoring_config not set. Set config before calling run().");
+    }
+
+    const vector<string>& feature_names = forest->get_feature_names();
+    const vector<string>& feature_types = forest->get_feature_types();
+
+    // Open both ends up front so bad paths fail before any thread starts
+    csv_chunk_reader reader(input_csv);
+    ofstream out(output_path);
+    if (!out.is_open()) {
+        throw runtime_error("Could not open file for writing: " + output_path);
+    }
+
+    // Locate feature columns; numeric features are always parsed as float so every
+    // block has the same schema regardless of what its values look like
+    vector<size_t> source_columns;
+    vector<string> block_types;
+    const vector<string>& headers = reader.get_headers();
+    for (size_t f = 0; f < feature_names.size(); ++f) {
+        size_t pos = 0;
+        while (pos < headers.size() && headers[pos] != feature_names[f]) ++pos;
+        if (pos == headers.size()) {
+            throw invalid_argument("Feature column not found in " + input_csv + ": " + feature_names[f]);
+        }
+        source_columns.push_back(pos);
+        block_types.push_back(feature_types[f] == "string" ? "string" : "float");
+    }
+
+    // Output header
+    out << "prediction";
+    if (config->write_probabilities && !forest->is_regressor()) {
+        for (int c = 0; c < forest->get_num_classes(); ++c) {
+            out << ",p_" << forest->get_class_label(c);
+        }
+    }
+    out << "\n";
+
+    bounded_queue<data_frame> parsed(config->queue_capacity);
+    bounded_queue<scored_block> scored(config->queue_capacity);
+    exception_ptr parse_error, write_error;
+    scoring_stats stats;
+
+    auto wall_start = chrono::high_resolution_clock::now();
+
+    // Stage 1: parse chunks of rows into feature-only data_frames
+    thread parser([&] {
+        try {
+            vector<vector<string>> rows;
+            vector<vector<string>> projected;
+            while (true) {
+                auto time_start = chrono::high_resolution_clock::now();
+                if (reader.read_chunk(rows, config->chunk_rows) == 0) break;
+
+                projected.assign(rows.size(), vector<string>(source_columns.size()));
+                for (size_t r = 0; r < rows.size(); ++r) {
+                    for (size_t f = 0; f < source_columns.size(); ++f) {
+                        projected[r][f] = move(rows[r][source_columns[f]]);
+                    }
+                }
+                data_frame block = data_frame::from_rows(feature_names, projected, &block_types);
+                stats.parse_ms += elapsed_ms(time_start);
+
+                if (!parsed.push(move(block))) break;
+            }
+        } catch (...) {
+            parse_error = current_exception();
+        }
+        parsed.close();
+    });
+
+    // Stage 3: format and write predictions
+    thread writer([&] {
+        try {
+            scored_block block;
+            while (scored.pop(block)) {
+                auto time_start = chrono::high_resolution_clock::now();
+
+                ostringstream lines;
+                lines.precision(17);
+                for (double value : block.values) {
+                    lines << value << "\n";
+                }
+                for (size_t r = 0; r < block.classes.size(); ++r) {
+                    lines << forest->get_class_label(block.classes[r]);
+                    if (!block.probabilities.empty()) {
+                        for (double p : block.probabilities[r]) lines << "," << p;
+                    }
+                    lines << "\n";
+                }
+                out << lines.str();
+                if (!out) throw runtime_error("Failed writing to " + output_path);
+
+                stats.write_ms += elapsed_ms(time_start);
+            }
+        } catch (...) {
+            write_error = current_exception();
+            scored.close();
+        }
+    });
+
+    // Stage 2 (this thread): predict each block with the forest's parallel inference
+    exception_ptr predict_error;
+    try {
+        data_frame block;
+        while (parsed.pop(block)) {
+            auto time_start = chrono::high_resolution_clock::now();
+            parsed_queue_depth.set(parsed.size());
+            scored_queue_depth.set(scored.size());
+
+            scored_block result;
+            if (forest->is_regressor()) {
+                result.values = forest->predict_values(block);
+            } else if (config->write_probabilities) {
+                // One traversal yields both the probabilities and their class
+                result.probabilities = forest->predict_proba(block, &result.classes);
+            } else {
+                result.classes = forest->predict(block);
+            }
+            stats.rows_scored += block.get_num_rows();
+            stats.chunks++;
+            stats.predict_ms += elapsed_ms(time_start);
+
+            if (!scored.push(move(result))) break;
+        }
+    } catch (...) {
+        predict_error = current_exception();
+    }
+
+    // Unblock the other stages if one of them stopped early, then wait for both
+    parsed.close();
+    scored.close();
+    parser.join();
+    writer.join();
+
+    if (parse_error) rethrow_exception(parse_error);
+    if (predict_error) rethrow_exception(predict_error);
+    if (write_error) rethrow_exception(write_error);
+
+    stats.wall_ms = elapsed_ms(wall_start);
+    return stats;
+}
@@ -0,0 +1,539 @@
+/*
+Local scoring daemon with micro-batching, and its load generator
+*/
+
+#include "server.hpp"
+#include "loaders.hpp"
+#include "metrics_registry.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <netinet/in.h>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+
+static metric_counter& requests_served = metrics_registry::global().get_counter(
+    "prf_server_requests_total", "PREDICT requests answered by the scoring server");
+static metric_histogram& batch_rows = metrics_registry::global().get_histogram(
+    "prf_server_batch_rows", "Rows per scoring micro-batch", metric_histogram::exponential_bounds(1, 2.0, 10));
+static metric_histogram& request_latency_seconds = metrics_registry::global().get_histogram(
+    "prf_server_request_latency_seconds", "Enqueue to prediction ready, per request",
+    metric_histogram::exponential_bounds(1e-5, 2.0, 18));
+static metric_gauge& server_queue_depth = metrics_registry::global().get_gauge(
+    "prf_server_queue_depth", "Requests waiting for a micro-batch (sampled once per batch)");
+
+// ==================== Socket Helpers ====================
+
+static sockaddr_un unix_address(const string& path) {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        throw invalid_argument("Invalid Unix socket path: '" + path + "'");
+    }
+    strcpy(address.sun_path, path.c_str());
+    return address;
+}
+
+static sockaddr_in loopback_address(int port) {
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return address;
+}
+
+static int connect_to(const string& socket_path, int tcp_port) {
+    int fd = socket(tcp_port > 0 ? AF_INET : AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        throw runtime_error(string("socket() failed: ") + strerror(errno));
+    }
+
+    int result;
+    if (tcp_port > 0) {
+        sockaddr_in address = loopback_address(tcp_port);
+        result = connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    } else {
+        sockaddr_un address = unix_address(socket_path);
+        result = connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    }
+    if (result < 0) {
+        string reason = strerror(errno);
+        close(fd);
+        throw runtime_error("Could not connect to scoring server: " + reason);
+    }
+    return fd;
+}
+
+static bool send_line(int fd, const string& line) {
+    string message = line + "\n";
+    size_t sent = 0;
+    while (sent < message.size()) {
+        ssize_t n = send(fd, message.data() + sent, message.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += n;
+    }
+    return true;
+}
+
+// Buffered newline-delimited reader over a socket
+class line_reader {
+private:
+    int fd;
+    string buffer;
+    size_t start = 0;
+
+public:
+    explicit line_reader(int fd) : fd(fd) {}
+
+    // Returns false on EOF or error
+    bool read_line(string& line) {
+        while (true) {
+            size_t end = buffer.find('\n', start);
+            if (end != string::npos) {
+                line.assign(buffer, start, end - start);
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                start = end + 1;
+                return true;
+            }
+
+            buffer.erase(0, start);
+            start = 0;
+            char chunk[4096];
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            buffer.append(chunk, n);
+        }
+    }
+};
+
+static double percentile(vector<double> values, double fraction) {
+    if (values.empty()) return 0.0;
+    size_t k = min(values.size() - 1, (size_t)(fraction * values.size()));
+    nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k];
+}
+
+static vector<string> split_fields(const string& text) {
+    vector<string> fields;
+    stringstream ss(text);
+    string field;
+    while (getline(ss, field, ',')) fields.push_back(field);
+    if (!text.empty() && text.back() == ',') fields.push_back("");
+    return fields;
+}
+
+// ==================== Scoring Server ====================
+
+void scoring_server::open_listener() {
+    listen_fd = socket(config->tcp_port > 0 ? AF_INET : AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        throw runtime_error(string("socket() failed: ") + strerror(errno));
+    }
+
+    int result;
+    if (config->tcp_port > 0) {
+        int reuse = 1;
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in address = loopback_address(config->tcp_port);
+        result = bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    } else {
+        sockaddr_un address = unix_address(config->socket_path);
+
+        // Replace a stale socket from a previous run, but never any other kind of file
+        struct stat existing;
+        if (lstat(config->socket_path.c_str(), &existing) == 0) {
+            if (!S_ISSOCK(existing.st_mode)) {
+                close(listen_fd);
+                listen_fd = -1;
+                throw runtime_error("Socket path exists and is not a socket: " + config->socket_path);
+            }
+            unlink(config->socket_path.c_str());
+        }
+        result = bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    }
+
+    if (result < 0 || listen(listen_fd, SOMAXCONN) < 0) {
+        string reason = strerror(errno);
+        close(listen_fd);
+        listen_fd = -1;
+        throw runtime_error("Could not listen for scoring requests: " + reason);
+    }
+}
+
+void scoring_server::run() {
+    if (!forest || forest->get_num_trees() == 0) {
+        throw runtime_error("Forest not fitted. Set a fitted forest before calling run().");
+    }
+    if (!config) {
+        throw runtime_error("server_config not set. Set config before calling run().");
+    }
+
+    queue.reset(new bounded_queue<pending_request*>(config->queue_capacity));
+    latencies_us.assign(max<size_t>(config->latency_window, 1), 0.0);
+    latency_next = 0;
+    total_requests = 0;
+    total_batches = 0;
+    started = chrono::steady_clock::now();
+    stopping = false;
+
+    open_listener();
+    thread batcher(&scoring_server::batch_loop, this);
+
+    vector<thread> connections;
+    while (!stopping) {
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break;  // Listener shut down by stop()
+        }
+
+        {
+            lock_guard<mutex> guard(clients_lock);
+            if (stopping) {
+                close(fd);
+                break;
+            }
+            client_fds.insert(fd);
+
+            // Join the threads of clients that have disconnected, so they do not pile up
+            for (thread::id id : finished_clients) {
+                auto finished = find_if(connections.begin(), connections.end(),
+                                        [&](const thread& connection) { return connection.get_id() == id; });
+                finished->join();
+                connections.erase(finished);
+            }
+            finished_clients.clear();
+        }
+        connections.emplace_back(&scoring_server::serve_client, this, fd);
+    }
+
+    // stop() has shut down every client socket, so their threads return
+    stop();
+    for (auto& connection : connections) connection.join();
+    queue->close();
+    batcher.join();
+
+    close(listen_fd);
+    listen_fd = -1;
+    if (config->tcp_port <= 0) unlink(config->socket_path.c_str());
+}
+
+void scoring_server::stop() {
+    lock_guard<mutex> guard(clients_lock);
+    stopping = true;
+    if (listen_fd >= 0) shutdown(listen_fd, SHUT_RDWR);
+    for (int fd : client_fds) shutdown(fd, SHUT_RDWR);
+}
+
+void scoring_server::batch_loop() {
+    size_t n_features = forest->get_feature_names().size();
+    int num_classes = forest->get_num_classes();
+    size_t max_batch = max<size_t>(config->max_batch_rows, 1);
+
+    vector<pending_request*> batch;
+    vector<double> rows;
+    vector<int> classes;
+    vector<double> probabilities;
+
+    pending_request* request;
+    while (queue->pop(request)) {
+        // The first request opens a batch; later ones join it until it is full or the wait expires
+        batch.assign(1, request);
+        auto deadline = chrono::steady_clock::now() + chrono::microseconds(config->max_wait_us);
+        while (batch.size() < max_batch && queue->try_pop_until(request, deadline)) {
+            batch.push_back(request);
+        }
+        server_queue_depth.set(queue->size());
+
+        rows.resize(batch.size() * n_features);
+        for (size_t r = 0; r < batch.size(); ++r) {
+            copy(batch[r]->row.begin(), batch[r]->row.end(), rows.begin() + r * n_features);
+        }
+        classes.resize(batch.size());
+        probabilities.resize(batch.size() * num_classes);
+        forest->predict_rows(rows.data(), batch.size(), classes.data(), probabilities.data());
+
+        auto finished = chrono::steady_clock::now();
+        {
+            lock_guard<mutex> guard(stats_lock);
+            total_requests += batch.size();
+            total_batches++;
+            for (auto* pending : batch) {
+                latencies_us[latency_next] = chrono::duration<double, micro>(finished - pending->received).count();
+                request_latency_seconds.observe(latencies_us[latency_next] / 1e6);
+                latency_next = (latency_next + 1) % latencies_us.size();
+            }
+        }
+        requests_served.add(batch.size());
+        batch_rows.observe(batch.size());
+
+        for (size_t r = 0; r < batch.size(); ++r) {
+            pending_request* pending = batch[r];
+            lock_guard<mutex> guard(pending->lock);
+            pending->predicted_class = classes[r];
+            pending->probabilities.assign(probabilities.begin() + r * num_classes,
+                                          probabilities.begin() + (r + 1) * num_classes);
+            pending->done = true;
+            pending->ready.notify_one();
+        }
+    }
+}
+
+string scoring_server::handle_line(const string& line) {
+    size_t space = line.find(' ');
+    string command = line.substr(0, space);
+    string argument = space == string::npos ? "" : line.substr(space + 1);
+
+    if (command == "PREDICT") {
+        const vector<string>& feature_names = forest->get_feature_names();
+        const vector<string>& feature_types = forest->get_feature_types();
+        vector<string> values = split_fields(argument);
+        if (values.size() != feature_names.size()) {
+            return "ERR expected " + to_string(feature_names.size()) + " values, got " + to_string(values.size());
+        }
+
+        pending_request request;
+        request.row.resize(values.size());
+        for (size_t f = 0; f < values.size(); ++f) {
+            if (feature_types[f] == "string") {
+                request.row[f] = forest->encode_category(f, values[f]);
+                continue;
+            }
+            if (is_missing_value(values[f])) {
+                request.row[f] = numeric_limits<double>::quiet_NaN();
+                continue;
+            }
+            try {
+                size_t parsed = 0;
+                request.row[f] = stod(values[f], &parsed);
+                if (parsed != values[f].size()) throw invalid_argument(values[f]);
+            } catch (const exception&) {
+                return "ERR bad numeric value for " + feature_names[f] + ": '" + values[f] + "'";
+            }
+        }
+
+        request.received = chrono::steady_clock::now();
+        if (!queue->push(&request)) {
+            return "ERR server shutting down";
+        }
+
+        unique_lock<mutex> guard(request.lock);
+        request.ready.wait(guard, [&] { return request.done; });
+
+        ostringstream response;
+        if (forest->is_regressor()) {
+            response.precision(17);
+            response << "OK " << request.probabilities[0];
+            return response.str();
+        }
+        response << "OK " << forest->get_class_label(request.predicted_class) << " ";
+        for (size_t c = 0; c < request.probabilities.size(); ++c) {
+            response << (c > 0 ? "," : "") << request.probabilities[c];
+        }
+        return response.str();
+    }
+
+    if (command == "INFO") {
+        ostringstream response;
+        response << "OK features=";
+        const vector<string>& feature_names = forest->get_feature_names();
+        for (size_t f = 0; f < feature_names.size(); ++f) {
+            response << (f > 0 ? "," : "") << feature_names[f];
+        }
+        if (forest->is_regressor()) {
+            response << " task=regression";
+        } else {
+            response << " classes=";
+            for (int c = 0; c < forest->get_num_classes(); ++c) {
+                response << (c > 0 ? "," : "") << forest->get_class_label(c);
+            }
+        }
+        response << " trees=" << forest->get_num_trees();
+        return response.str();
+    }
+
+    if (command == "STATS") {
+        server_stats stats = get_stats();
+        ostringstream response;
+        response << "OK requests=" << stats.requests
+                 << " batches=" << stats.batches
+                 << " mean_batch=" << stats.mean_batch_rows
+                 << " p50_us=" << stats.p50_latency_us
+                 << " p99_us=" << stats.p99_latency_us
+                 << " rps=" << stats.throughput_rps;
+        return response.str();
+    }
+
+    if (command == "SHUTDOWN") {
+        return "OK";
+    }
+
+    return "ERR unknown command '" + command + "'";
+}
+
+void scoring_server::serve_client(int fd) {
+    line_reader reader(fd);
+    string line;
+    while (reader.read_line(line)) {
+        if (line.empty()) continue;
+
+        string response;
+        try {
+            response = handle_line(line);
+        } catch (const exception& e) {
+            response = string("ERR ") + e.what();
+        }
+        if (!send_line(fd, response)) break;
+
+        if (line == "SHUTDOWN") {
+            stop();
+            break;
+        }
+    }
+
+    lock_guard<mutex> guard(clients_lock);
+    client_fds.erase(fd);
+    close(fd);
+    finished_clients.push_back(this_thread::get_id());
+}
+
+server_stats scoring_server::get_stats() const {
+    server_stats stats;
+    vector<double> window;
+    {
+        lock_guard<mutex> guard(stats_lock);
+        stats.requests = total_requests;
+        stats.batches = total_batches;
+        window.assign(latencies_us.begin(), latencies_us.begin() + min(total_requests, latencies_us.size()));
+    }
+
+    if (stats.batches > 0) {
+        stats.mean_batch_rows = (double)stats.requests / stats.batches;
+    }
+    stats.p50_latency_us = percentile(window, 0.50);
+    stats.p99_latency_us = percentile(window, 0.99);
+
+    double elapsed_s = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    if (elapsed_s > 0) {
+        stats.throughput_rps = stats.requests / elapsed_s;
+    }
+    return stats;
+}
+
+// ==================== Load Generator ====================
+
+load_test_result run_load_test(const load_test_config& config) {
+    if (config.num_clients <= 0 || config.requests_per_client <= 0) {
+        throw invalid_argument("Load test needs at least one client and one request per client");
+    }
+
+    // Ask the server which columns it expects
+    vector<string> feature_names;
+    {
+        int fd = connect_to(config.socket_path, config.tcp_port);
+        line_reader reader(fd);
+        string response;
+        bool ok = send_line(fd, "INFO") && reader.read_line(response);
+        close(fd);
+
+        size_t start = response.find("features=");
+        if (!ok || response.compare(0, 3, "OK ") != 0 || start == string::npos) {
+            throw runtime_error("Unexpected INFO response from scoring server: '" + response + "'");
+        }
+        start += strlen("features=");
+        feature_names = split_fields(response.substr(start, response.find(' ', start) - start));
+    }
+
+    // Pre-format one request line per CSV row
+    csv_chunk_reader csv(config.csv_path);
+    const vector<string>& headers = csv.get_headers();
+    vector<size_t> source_columns;
+    for (const auto& name : feature_names) {
+        auto it = find(headers.begin(), headers.end(), name);
+        if (it == headers.end()) {
+            throw invalid_argument("Feature column not found in " + config.csv_path + ": " + name);
+        }
+        source_columns.push_back(it - headers.begin());
+    }
+
+    vector<string> request_lines;
+    vector<vector<string>> rows;
+    while (csv.read_chunk(rows, 65536) > 0) {
+        for (const auto& row : rows) {
+            string line = "PREDICT ";
+            for (size_t f = 0; f < source_columns.size(); ++f) {
+                line += (f > 0 ? "," : "") + row[source_columns[f]];
+            }
+            request_lines.push_back(move(line));
+        }
+    }
+    if (request_lines.empty()) {
+        throw runtime_error("No rows to send in " + config.csv_path);
+    }
+
+    // Each client walks the rows from its own offset, one request in flight at a time
+    vector<vector<double>> client_latencies(config.num_clients);
+    vector<size_t> client_errors(config.num_clients, 0);
+    vector<string> client_failures(config.num_clients);
+
+    auto wall_start = chrono::steady_clock::now();
+    vector<thread> clients;
+    for (int c = 0; c < config.num_clients; ++c) {
+        clients.emplace_back([&, c] {
+            try {
+                int fd = connect_to(config.socket_path, config.tcp_port);
+                line_reader reader(fd);
+                string response;
+                client_latencies[c].reserve(config.requests_per_client);
+
+                for (int i = 0; i < config.requests_per_client; ++i) {
+                    const string& line = request_lines[((size_t)c * config.requests_per_client + i) % request_lines.size()];
+                    auto sent_at = chrono::steady_clock::now();
+                    if (!send_line(fd, line) || !reader.read_line(response)) {
+                        close(fd);
+                        throw runtime_error("Connection closed by scoring server");
+                    }
+                    client_latencies[c].push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - sent_at).count());
+                    if (response.compare(0, 3, "OK ") != 0) client_errors[c]++;
+                }
+                close(fd);
+            } catch (const exception& e) {
+                client_failures[c] = e.what();
+            }
+        });
+    }
+    for (auto& client : clients) client.join();
+
+    for (const auto& failure : client_failures) {
+        if (!failure.empty()) throw runtime_error("Load test client failed: " + failure);
+    }
+
+    load_test_result result;
+    result.wall_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - wall_start).count();
+
+    vector<double> latencies;
+    for (int c = 0; c < config.num_clients; ++c) {
+        latencies.insert(latencies.end(), client_latencies[c].begin(), client_latencies[c].end());
+        result.errors += client_errors[c];
+    }
+    result.requests = latencies.size();
+    result.throughput_rps = result.requests / (result.wall_ms / 1000.0);
+    result.p50_latency_us = percentile(latencies, 0.50);
+    result.p99_latency_us = percentile(latencies, 0.99);
+    result.max_latency_us = *max_element(latencies.begin(), latencies.end());
+    return result;
+}
@@ -0,0 +1,111 @@
+/*
+In-memory synthetic data sets for scale benchmarks
+*/
+
+#include "synthetic.hpp"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <omp.h>
+
+using namespace std;
+
+const string SYNTHETIC_TARGET = "label";
+
+static const size_t BLOCK_ROWS = 65536;
+
+vector<string> synthetic_feature_names(const synthetic_config& config) {
+    vector<string> names;
+    for (int f = 0; f < config.num_numeric_features; ++f) {
+        names.push_back("num_" + to_string(f));
+    }
+    for (int f = 0; f < config.num_categorical_features; ++f) {
+        names.push_back("cat_" + to_string(f));
+    }
+    return names;
+}
+
+data_frame make_synthetic(const synthetic_config& config) {
+    if (config.num_rows == 0 || config.num_classes < 2) {
+        throw invalid_argument("Synthetic data needs at least one row and two classes");
+    }
+    if (config.num_numeric_features < 0 || config.num_categorical_features < 0 ||
+        config.num_numeric_features + config.num_categorical_features == 0) {
+        throw invalid_argument("Synthetic data needs at least one feature");
+    }
+    if (config.num_categorical_features > 0 && config.categories_per_feature < 2) {
+        throw invalid_argument("categories_per_feature must be at least 2");
+    }
+    if (config.noise < 0.0 || config.noise > 1.0 || config.imbalance < 1.0) {
+        throw invalid_argument("noise must be in [0, 1] and imbalance at least 1");
+    }
+    
+    int n_numeric = config.num_numeric_features;
+    int n_categorical = config.num_categorical_features;
+    int n_classes = config.num_classes;
+    size_t n_rows = config.num_rows;
+    
+    // Class structure, drawn serially from the seed
+    mt19937_64 rng(config.seed);
+    uniform_real_distribution<double> unit(-1.0, 1.0);
+    uniform_int_distribution<int> any_category(0, max(config.categories_per_feature - 1, 0));
+    
+    vector<double> centers(n_classes * n_numeric);
+    for (double& center : centers) center = config.class_separation * unit(rng);
+    
+    vector<int> preferred(n_classes * n_categorical);
+    for (int& category : preferred) category = any_category(rng);
+    
+    // Geometric class frequencies from 1 down to 1 / imbalance
+    vector<double> class_weights(n_classes);
+    for (int c = 0; c < n_classes; ++c) {
+        class_weights[c] = pow(config.imbalance, -(double)c / (n_classes - 1));
+    }
+    
+    vector<vector<double>> numeric(n_numeric, vector<double>(n_rows));
+    vector<vector<string>> categorical(n_categorical, vector<string>(n_rows));
+    vector<int> labels(n_rows);
+    
+    vector<string> category_names(max(config.categories_per_feature, 0));
+    for (size_t k = 0; k < category_names.size(); ++k) {
+        category_names[k] = "c" + to_string(k);
+    }
+    
+    long long n_blocks = (n_rows + BLOCK_ROWS - 1) / BLOCK_ROWS;
+    #pragma omp parallel for schedule(dynamic)
+    for (long long block = 0; block < n_blocks; ++block) {
+        mt19937_64 block_rng(config.seed ^ (0x9E3779B97F4A7C15ULL * (block + 1)));
+        discrete_distribution<int> pick_class(class_weights.begin(), class_weights.end());
+        uniform_int_distribution<int> random_class(0, n_classes - 1);
+        uniform_int_distribution<int> random_category(0, max(config.categories_per_feature - 1, 0));
+        normal_distribution<double> gaussian(0.0, 1.0);
+        uniform_real_distribution<double> coin(0.0, 1.0);
+        
+        size_t end = min(n_rows, (size_t)(block + 1) * BLOCK_ROWS);
+        for (size_t row = (size_t)block * BLOCK_ROWS; row < end; ++row) {
+            int label = pick_class(block_rng);
+            for (int f = 0; f < n_numeric; ++f) {
+                numeric[f][row] = centers[label * n_numeric + f] + gaussian(block_rng);
+            }
+            for (int f = 0; f < n_categorical; ++f) {
+                int category = coin(block_rng) < 0.5 ? preferred[label * n_categorical + f] : random_category(block_rng);
+                categorical[f][row] = category_names[category];
+            }
+            labels[row] = coin(block_rng) < config.noise ? random_class(block_rng) : label;
+        }
+    }
+    
+    data_frame df;
+    vector<string> names = synthetic_feature_names(config);
+    for (int f = 0; f < n_numeric; ++f) {
+        df.add_column(names[f], make_unique<float_col>(numeric[f]));
+        vector<double>().swap(numeric[f]);  // Release as we go: peak memory stays near one copy
+    }
+    for (int f = 0; f < n_categorical; ++f) {
+        df.add_column(names[n_numeric + f], make_unique<string_col>(categorical[f]));
+        vector<string>().swap(categorical[f]);
+    }
+    df.add_column(SYNTHETIC_TARGET, make_unique<int_col>(labels));
+    return df;
+}